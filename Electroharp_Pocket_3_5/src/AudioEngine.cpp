@@ -0,0 +1,626 @@
+#include "AudioEngine.h"
+#include "LatencyProbe.h"
+#include "Profiler.h"
+#include "SplitRender.h"
+
+AudioEngine audioEngine;
+
+// --- Sound Profiles ---
+// Bluetooth: High Fidelity, Balanced, Lush
+SoundProfile btProfile = {
+    0.90f, // Saw
+    0.50f, // Square
+    0.40f, // Sine (Deep Reduction for Polyphony)
+    0.80f, // Tri
+    0.55f, // Master (Headroom for Delay)
+    2.0f   // Release
+};
+
+// Speaker: Loud, Punchy, Short Tail
+SoundProfile spkProfile = {
+    0.19f, // Saw
+    0.30f, // Square
+    0.20f, // Sine (Deep Reduction)
+    0.52f, // Tri
+    0.65f, // Master
+    2.0f   // Release
+};
+
+SoundProfile *currentProfile = &btProfile; // Default to BT settings mostly
+
+// --- PARAMETER SNAPSHOT ---
+EngineInputs currentEngineInputs() {
+  EngineInputs in;
+  in.params = activeParams;
+  in.profile = currentProfile;
+  in.waveform = currentWaveform;
+  in.fxDrive = fxDrive;
+  in.fxTrem = fxTrem;
+  in.fxLFO = fxLFO;
+  in.delayMode = delayMode;
+  in.masterVolume = masterVolume;
+  in.testTone = isAudioTestRunning;
+  in.softRestart = softRestart;
+  in.outputLsb = outputLsb;
+  in.sampleRate = activeSampleRate;
+  return in;
+}
+
+// Build + Publish (UI core)
+void AudioEngine::publishParams(const EngineInputs &in) {
+  float fs = (in.sampleRate > 0) ? (float)in.sampleRate : 22050.0f;
+  const SynthParameters &sp = in.params;
+  ParamSnapshot p;
+
+  // Filter
+  p.filter.update(sp.filterCutoff, fs, sp.filterRes, in.waveform,
+                  in.profile == &btProfile);
+
+  // Modulator Rates
+  p.lfoInc = sp.lfoRate / fs;
+  p.lfoDepth = sp.lfoDepth;
+  p.lfoType = sp.lfoType;
+  p.lfoTarget = sp.lfoTarget;
+  p.waveFold = sp.waveFold;
+  p.wowInc = 2.0f / fs;
+  p.flutterInc = 3.0f / fs;
+  p.tremInc = sp.tremRate / fs;
+  p.fxLFO = in.fxLFO;
+  p.fxDrive = in.fxDrive;
+  p.fxTrem = in.fxTrem;
+
+  // Mix / FX
+  p.masterGain = in.profile->masterGain;
+  p.drive = 1.0f + sp.driveAmount * 3.0f;
+  p.delayFeedback = sp.delayFeedback;
+  p.delayMode = in.delayMode;
+  p.delaySamples = ((int)fs / DELAY_DOWNSAMPLE * (in.delayMode * 300)) / 1000;
+  p.masterVolume = in.masterVolume;
+
+  p.testTone = in.testTone;
+  p.testInc = 2.0f * PI * 440.0f / fs;
+
+  p.envAttack = sp.attackTime;
+  p.envDecay = 0.1f;
+  p.envSustain = 0.7f;
+  p.envRelease = sp.releaseTime;
+  p.softRestart = in.softRestart;
+
+  // Early retirement: output LSB referred back to a voice at worst-case
+  // gain (resonance peak, drive, polyScale 1), split across the pool
+  float chainGain = p.masterGain * p.masterVolume * RETIRE_RES_PEAK *
+                    (p.fxDrive ? p.drive : 1.0f);
+  p.retireLevel =
+      (chainGain > 0.0f)
+          ? RETIRE_LSB_FRACTION * in.outputLsb / (chainGain * MAX_VOICES)
+          : 0.0f;
+
+  paramBuffer.publish(p);
+}
+
+// Pick up the latest snapshot (audio core, block boundary)
+void IRAM_ATTR AudioEngine::acquireParams() {
+  if (!paramBuffer.read(params, paramSeq))
+    return;
+  // Voice sync rides the snapshot, not the event queue: a stalled render
+  // loop must not fill the queue with state and crowd out releases
+  SynthVoice *voices = pool.voices;
+  for (int v = 0; v < MAX_VOICES; v++) {
+    if (!voices[v].isSparkle)
+      voices[v].setADSR(params.envAttack, params.envDecay, params.envSustain,
+                        params.envRelease);
+    voices[v].setPulseWidth(params.waveFold);
+  }
+}
+
+// Active FX set as a governor cost key
+uint8_t IRAM_ATTR AudioEngine::fxKey() const {
+  return (params.fxDrive ? GOV_FX_DRIVE : 0) |
+         (params.fxTrem ? GOV_FX_TREM : 0) |
+         (params.delayMode > 0 ? GOV_FX_DELAY : 0) |
+         (params.fxLFO ? GOV_FX_LFO : 0);
+}
+
+// --- FILTER COEFFICIENTS ---
+void FilterCoeffs::update(float cutoff, float fs, float filterRes,
+                          Waveform wave, bool isBT) {
+  cutoffHz = cutoff;
+
+  // svf_f = 2 * sin(PI * Fc / Fs)
+  f = 2.0f * sin(PI * cutoff / fs);
+  if (f > 0.85f)
+    f = 0.85f; // More conservative limit for stability
+  if (f < 0.005f)
+    f = 0.005f;
+
+  res = filterRes;
+
+  // --- v3.5 Q-Compensation Logic ---
+  // Waveform-dependent Resonance Tuning
+  qScale = 1.0f;
+  if (wave == WAVE_SAW) {
+    qScale *= 2.6f; // +30%
+  } else if (wave == WAVE_SINE) {
+    qScale *= 3.9f; // +30%
+  }
+
+  // Profile Specific Safety
+  if (!isBT) {
+    qScale *= 2.34f; // +30% from 1.8f
+  } else {
+    qScale *= 2.275f; // +30% from 1.75f
+    if (wave == WAVE_SINE)
+      qScale *= 1.95f; // +30% from 1.5f
+    else if (wave == WAVE_SQUARE)
+      qScale *= 1.95f;
+    else if (wave == WAVE_TRIANGLE)
+      qScale *= 1.56f; // +30% from 1.2f
+  }
+
+  q = dampingFor(1.0f);
+}
+
+float FilterCoeffs::dampingFor(float resMod) const {
+  float baseRes = res * resMod;
+  if (baseRes > 0.95f)
+    baseRes = 0.95f;
+  if (baseRes < 0.01f)
+    baseRes = 0.01f;
+
+  // Convert Res to Q (damping). Low Damping = High Res.
+  float damp = (1.0f - baseRes) * qScale;
+  if (damp > 1.0f)
+    damp = 1.0f;
+  return damp;
+}
+
+void CutoffTable::build(float fs) {
+  for (int i = 0; i <= CUTOFF_TABLE_SIZE; i++) {
+    float hz = (fs * 0.5f) * (float)i / (float)CUTOFF_TABLE_SIZE;
+    float f = 2.0f * sin(PI * hz / fs);
+    if (f > 0.85f)
+      f = 0.85f;
+    if (f < 0.005f)
+      f = 0.005f;
+    coeff[i] = f;
+  }
+  hzToIndex = (float)CUTOFF_TABLE_SIZE / (fs * 0.5f);
+}
+
+void AudioEngine::buildTables() {
+  float fs = (activeSampleRate > 0) ? (float)activeSampleRate : 22050.0f;
+  cutoffTable.build(fs);
+  governor.setRate((int)fs);
+}
+
+// State Variable Filter for one (already mixed) sample
+float IRAM_ATTR AudioEngine::processFilter(float mixedSample, float f,
+                                           float q) {
+  // Anti-Denormal noise
+  mixedSample += 1.0e-18f;
+
+  svfLow += f * svfBand;
+  float high = mixedSample - svfLow - (q * svfBand);
+  svfBand += f * high;
+
+  // Clip (Hard Clip Filter States)
+  if (svfLow > 2.0f)
+    svfLow = 2.0f;
+  else if (svfLow < -2.0f)
+    svfLow = -2.0f;
+  if (svfBand > 2.0f)
+    svfBand = 2.0f;
+  else if (svfBand < -2.0f)
+    svfBand = -2.0f;
+
+  return svfLow;
+}
+
+// --- NOTE EVENTS ---
+bool AudioEngine::post(NoteEvent &e) {
+  e.time = micros();
+  if (!noteEvents.push(e)) {
+    droppedEvents++;
+    return false;
+  }
+  return true;
+}
+
+// Drain the UI event queue (start of every block)
+void IRAM_ATTR AudioEngine::processEvents() {
+  SynthVoice *voices = pool.voices;
+  NoteEvent e;
+  while (noteEvents.pop(e)) {
+    switch (e.type) {
+    case EVT_NOTE_ON: {
+      // Output was stopped (no consumer): don't burst out old notes later
+      if ((int32_t)(micros() - e.time) > NOTE_EVENT_MAX_AGE_US)
+        break;
+      if (e.freq < 1.0f)
+        break; // trigger() would ignore it
+      lastWave = (Waveform)e.waveform;
+      bool latched = (e.role == ROLE_LATCHED_ARP);
+
+      // Same string still sounding at the same pitch (swiped back over it,
+      // arp repeat): retrigger that voice instead of stacking another
+      int v = pool.findNote(e.noteIdx);
+      bool reuse = v != VOICE_NONE && voices[v].isLatchedArp == latched &&
+                   fabs(voices[v].frequency - e.freq) < e.freq * 0.001f;
+
+      if (reuse) {
+        pool.restart(v);
+      } else {
+        // Free voice only if the predicted block cost still fits
+        v = pool.allocate(governor.voiceLimit(fxKey(), lastWave));
+        if (v == VOICE_NONE)
+          break;
+      }
+
+      if (reuse && params.softRestart)
+        voices[v].softTrigger(e.freq, e.noteIdx, (Waveform)e.waveform, e.pw,
+                              e.attack, e.decay, e.sustain, e.release);
+      else
+        voices[v].trigger(e.freq, e.noteIdx, (Waveform)e.waveform, e.pw,
+                          e.attack, e.decay, e.sustain, e.release);
+      voices[v].isSparkle = (e.role == ROLE_SPARKLE);
+      voices[v].isLatchedArp = (e.role == ROLE_LATCHED_ARP);
+      pool.start(v);
+      if (e.touchTime != 0 && instrumented)
+        latencyProbe.noteStarted(e.touchTime);
+      break;
+    }
+
+    case EVT_RELEASE_HELD:
+      for (int v = pool.first(); v != VOICE_NONE; v = pool.next(v)) {
+        if (voices[v].held && !voices[v].isLatchedArp) {
+          voices[v].release();
+          pool.released(v);
+        }
+      }
+      break;
+
+    case EVT_RELEASE_UNLATCHED:
+      for (int v = pool.first(); v != VOICE_NONE; v = pool.next(v)) {
+        if (!voices[v].isLatchedArp) {
+          voices[v].release();
+          pool.released(v);
+        }
+      }
+      break;
+
+    case EVT_RELEASE_LATCHED:
+      // Don't stop at the first one, in case multiple got stuck
+      for (int v = pool.first(); v != VOICE_NONE; v = pool.next(v)) {
+        if (voices[v].isLatchedArp) {
+          voices[v].release();
+          pool.released(v);
+        }
+      }
+      break;
+
+    case EVT_RELEASE_ALL:
+      for (int v = pool.first(); v != VOICE_NONE; v = pool.next(v)) {
+        voices[v].isLatchedArp = false;
+        voices[v].release();
+        pool.released(v);
+      }
+      break;
+
+    case EVT_ENV_PARAMS:
+      // Global update for simplicity (idle voices keep the stored settings)
+      for (int v = 0; v < MAX_VOICES; v++) {
+        voices[v].attackTime = e.attack;
+        voices[v].releaseTime = e.release;
+        voices[v].attackRate = 1.0f / (e.attack * activeSampleRate);
+        if (!voices[v].shedding)
+          voices[v].releaseRate = 1.0f / (e.release * activeSampleRate);
+        voices[v].setWaveform((Waveform)e.waveform);
+        if (voices[v].active && voices[v].envState == ENV_RELEASE)
+          pool.released(v); // Re-key: new release rate
+      }
+      lastWave = (Waveform)e.waveform;
+      break;
+
+    }
+  }
+}
+
+// --- VOICE SHEDDING ---
+// The governor limit dropped below the sounding voices (FX / waveform
+// change, cost spike, arp + sparkle allocations): fade the cheapest-to-lose
+// voices out over SHED_TIME instead of overrunning the block or leaving it
+// to a later note-on to hard-steal them mid-waveform. The overload has to
+// last SHED_HOLD_BLOCKS first: one slow block must not cut audible notes.
+void IRAM_ATTR AudioEngine::shedVoices() {
+  int limit = governor.voiceLimit(fxKey(), lastWave);
+  if (pool.count() <= limit) {
+    overLimitBlocks = 0;
+    return;
+  }
+  if (overLimitBlocks < SHED_HOLD_BLOCKS) {
+    overLimitBlocks++;
+    return;
+  }
+
+  SynthVoice *voices = pool.voices;
+  int live = 0;
+  for (int v = pool.first(); v != VOICE_NONE; v = pool.next(v)) {
+    if (!voices[v].shedding)
+      live++;
+  }
+
+  for (int excess = live - limit; excess > 0; excess--) {
+    // Rank: audible level (a voice in attack counts as full), halved when
+    // already releasing, weighted up with age rank so older voices go first
+    int victim = VOICE_NONE;
+    float best = 1.0e9f;
+    int age = 0;
+    for (int v = pool.first(); v != VOICE_NONE; v = pool.next(v), age++) {
+      const SynthVoice &sv = voices[v];
+      if (sv.shedding)
+        continue;
+      float level = (sv.envState == ENV_ATTACK) ? 1.0f : sv.envelope;
+      if (sv.envState == ENV_RELEASE)
+        level *= 0.5f;
+      float score = level * (1.0f + (float)age / MAX_VOICES);
+      if (score < best) {
+        best = score;
+        victim = v;
+      }
+    }
+    if (victim == VOICE_NONE)
+      break;
+    voices[victim].fastRelease(SHED_TIME);
+    pool.released(victim);
+    voicesShed++;
+  }
+}
+
+// Filter + Delay tails have decayed (call only when no voice is active)
+bool IRAM_ATTR AudioEngine::tailSilent() {
+  if (idle)
+    return true;
+
+  // SVF still ringing
+  if (fabs(svfLow) + fabs(svfBand) > SILENCE_THRESHOLD)
+    return false;
+
+  // Delay: every tap the read head can still reach must be quiet
+  if (params.delayMode > 0 && delayQuietTaps < params.delaySamples)
+    return false;
+
+  // Enter Idle: flush residue so a later delay-time change reads silence
+  memset(delayBuffer, 0, sizeof(delayBuffer));
+  delayQuietTaps = MAX_DELAY_LEN;
+  delayLpfState = 0.0f;
+  svfLow = 0.0f;
+  svfBand = 0.0f;
+  idle = true;
+  return true;
+}
+
+// Render one block (n <= AUDIO_BLOCK_SIZE)
+void IRAM_ATTR AudioEngine::renderBlock(float *out, int n) {
+  uint32_t govStart = profCycles();
+  PROF_DECLARE(profBlock);
+  pool.advance(n);
+  PROF_DECLARE(profT);
+  PROF_ACC(profEvents);
+  PROF_ACC(profMod);
+  PROF_ACC(profVoices);
+  PROF_ACC(profSvf);
+  PROF_ACC(profDrive);
+  PROF_ACC(profDelay);
+  PROF_ACC(profTrem);
+
+  // 0. Apply queued UI events + latest parameters at the block boundary
+  processEvents();
+  acquireParams();
+  shedVoices(); // Over the governor limit: fade out the cheapest voices
+  const ParamSnapshot &p = params;
+  PROF_LAP(profT, profEvents);
+  if (instrumented) {
+    PROF_RECORD(PROF_EVENTS, profEvents);
+  }
+
+  // Silence Fast Path: nothing sounding, nothing ringing -> skip all DSP.
+  // Checked after the events, so a note-on renders in this same block.
+  if (pool.count() == 0 && !p.testTone && tailSilent()) {
+    memset(out, 0, n * sizeof(float));
+    if (instrumented) {
+      PROF_RECORD(PROF_BLOCK, profCycles() - profBlock);
+    }
+    governor.idleBlock();
+    return;
+  }
+  idle = false;
+
+  // 1. Modulators (control rate, ramped per sample)
+  ModBuffers mods;
+  modulation.process(p, mods, n);
+  ModBlock mod = {mods.pitch, mods.pw};
+  PROF_LAP(profT, profMod);
+
+  // 2. Voices (accumulated into the mix buffer)
+  float mix[AUDIO_BLOCK_SIZE];
+  memset(mix, 0, n * sizeof(float));
+  int activeCount = pool.count();
+
+  float gain = 1.0f;
+  float polyScale = 1.0f;
+  if (activeCount > 0) {
+    // Dynamic Gain Scaling for Polyphony > 4
+    if (activeCount > 4) {
+      polyScale = 4.0f / (float)activeCount;
+    }
+    gain = p.masterGain * polyScale;
+  }
+  // No polyScale credit: it rises back toward 1 as the other voices end
+  float retireLevel = p.retireLevel;
+  int retired = 0;
+  uint32_t voiceStart = profCycles();
+
+  // Render order (oldest first); a split worker takes the newer part
+  int list[MAX_VOICES];
+  int count = 0;
+  uint8_t waveVoices[4] = {0, 0, 0, 0}; // Governor: cost per waveform
+  for (int v = pool.first(); v != VOICE_NONE; v = pool.next(v)) {
+    list[count++] = v;
+    waveVoices[pool.voices[v].renderWave()]++;
+  }
+  int local =
+      (split != NULL) ? split->kick(pool.voices, list, count, n, mod) : count;
+
+  for (int i = 0; i < local; i++)
+    pool.voices[list[i]].renderBlock(mix, n, mod);
+  bool splitBlock = false;
+  if (local < count)
+    splitBlock = split->join(mix, n); // Barrier: worker voices summed in
+
+  // Retire after the barrier (the pool is audio-core only). A voice is
+  // done once it can only fall: releasing, or decaying / held at a sustain
+  // that is itself inaudible (sparkle, sparkle arp: sustain 0, still held)
+  for (int i = 0; i < count; i++) {
+    int v = list[i];
+    SynthVoice &voice = pool.voices[v];
+    bool settling = voice.envState == ENV_RELEASE ||
+                    ((voice.envState == ENV_DECAY ||
+                      voice.envState == ENV_SUSTAIN) &&
+                     voice.sustainLvl * voice.mixGain < retireLevel);
+    if (voice.active && settling &&
+        voice.envelope * voice.mixGain < retireLevel) {
+      voice.retireNow(); // Inaudible tail
+      retired++;
+    }
+    if (!voice.active)
+      pool.retire(v); // Release finished
+  }
+  uint32_t voiceCycles = profCycles() - voiceStart;
+  voicesRetired += retired;
+  PROF_LAP(profT, profVoices);
+
+  // 3. Filter + FX (per sample)
+  float drive = p.drive;
+  float fbAmt = p.delayFeedback;
+  int delaySamples = p.delaySamples;
+  bool delayOn = p.delayMode > 0;
+  bool driveOn = p.fxDrive;
+  float volume = p.masterVolume;
+
+  // Filter Coefficients (LFO -> Res is applied at control rate)
+  float svfF = p.filter.f;
+  float svfQ = p.filter.q;
+  if (p.fxLFO && p.lfoTarget == TARGET_RES)
+    svfQ = p.filter.dampingFor(mods.resMod);
+
+  // LFO -> Filter: interpolated cutoff, mapped through the table per sample
+  float cutoffBase = p.filter.cutoffHz;
+  const float *cutoffMod = mods.cutoffActive ? mods.cutoff : NULL;
+
+  for (int i = 0; i < n; i++) {
+    if (cutoffMod)
+      svfF = cutoffTable.lookup(cutoffBase + cutoffMod[i]);
+    float sample = processFilter(mix[i] * gain, svfF, svfQ);
+    PROF_LAP(profT, profSvf);
+
+    // FX: Drive
+    if (driveOn) {
+      sample *= drive;
+      if (sample > 1.2f)
+        sample = 1.2f;
+      if (sample < -1.2f)
+        sample = -1.2f;
+      sample = sample - (sample * sample * sample) * 0.333f;
+    }
+    PROF_LAP(profT, profDrive);
+
+    // Delay Processing
+    delayTick++;
+    if (delayTick >= DELAY_DOWNSAMPLE)
+      delayTick = 0;
+
+    float delayed = 0.0f;
+    if (delayOn) {
+      int readPos = (delayHead - delaySamples + MAX_DELAY_LEN) % MAX_DELAY_LEN;
+      delayed = (float)delayBuffer[readPos] * 3.3333e-5f;
+    }
+
+    float dry = sample;
+    sample = dry + delayed * 0.5f;
+    PROF_LAP(profT, profDelay);
+
+    // FX: Tremolo (ramped gain, 1.0 when off)
+    sample *= mods.trem[i];
+    PROF_LAP(profT, profTrem);
+
+    // Delay Write
+    if (delayTick == 0) {
+      int16_t tap = 0;
+      if (delayOn) {
+        float fb = delayed * fbAmt + dry * 0.7f;
+
+        // Damping (One-pole LPF ~0.66 coeff)
+        delayLpfState = delayLpfState * 0.34f + fb * 0.66f;
+        fb = delayLpfState;
+
+        if (fb > 1.0f)
+          fb = 1.0f;
+        if (fb < -1.0f)
+          fb = -1.0f;
+        tap = (int16_t)(fb * 30000.0f);
+      }
+      delayBuffer[delayHead] = tap;
+
+      // Idle Detector: count consecutive inaudible taps
+      if (tap <= DELAY_QUIET_LEVEL && tap >= -DELAY_QUIET_LEVEL) {
+        if (delayQuietTaps < MAX_DELAY_LEN)
+          delayQuietTaps++;
+      } else {
+        delayQuietTaps = 0;
+      }
+      delayHead++;
+      if (delayHead >= MAX_DELAY_LEN)
+        delayHead = 0;
+    }
+    PROF_LAP(profT, profDelay);
+
+    // Master Volume
+    sample *= volume;
+
+    // --- Audio Test Tone (Audio Config Screen) ---
+    if (p.testTone) {
+      testPhase += p.testInc;
+      if (testPhase >= 2.0f * PI)
+        testPhase -= 2.0f * PI;
+      sample += sin(testPhase) * 0.3f;
+    }
+
+    out[i] = sample;
+    PROF_SKIP(profT); // Volume / test tone not attributed
+  }
+
+  if (instrumented) {
+    PROF_RECORD(PROF_MODULATION, profMod);
+    PROF_RECORD(PROF_VOICES, profVoices);
+    PROF_RECORD(PROF_SVF, profSvf);
+    PROF_RECORD(PROF_DRIVE, profDrive);
+    PROF_RECORD(PROF_DELAY, profDelay);
+    PROF_RECORD(PROF_TREM, profTrem);
+    PROF_RECORD(PROF_BLOCK, profCycles() - profBlock);
+  }
+
+  governor.learnBlock(fxKey(), lastWave, waveVoices, n, splitBlock,
+                      voiceCycles, profCycles() - govStart);
+  if (instrumented)
+    latencyProbe.blockRendered();
+}
+
+// Render any number of samples
+void IRAM_ATTR AudioEngine::render(float *out, int n) {
+  for (int base = 0; base < n; base += AUDIO_BLOCK_SIZE) {
+    int len = n - base;
+    if (len > AUDIO_BLOCK_SIZE)
+      len = AUDIO_BLOCK_SIZE;
+    renderBlock(out + base, len);
+  }
+}
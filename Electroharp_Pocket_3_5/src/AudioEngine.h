@@ -0,0 +1,278 @@
+#ifndef AUDIO_ENGINE_H
+#define AUDIO_ENGINE_H
+
+#include "Config.h"
+#include "Governor.h"
+#include "Modulation.h"
+#include "Platform.h"
+#include "SeqDoubleBuffer.h"
+#include "SpscQueue.h"
+#include "SynthVoice.h"
+#include "VoicePool.h"
+
+class SplitRender;
+
+// --- Delay Settings ---
+#define MAX_DELAY_MS 1200
+// Downsample Factor: 6 for "Lo-Fi" efficiency (Allows 12 voices on BT)
+#define DELAY_DOWNSAMPLE 6
+#define MAX_DELAY_LEN (int)(44100 * MAX_DELAY_MS / 1000 / DELAY_DOWNSAMPLE)
+
+// --- Voice Shedding ---
+#define SHED_TIME 0.005f   // Fade-out for voices over the governor limit (s)
+#define SHED_HOLD_BLOCKS 8 // Blocks over the limit before shedding (~12ms)
+
+// --- Early Retirement ---
+// A released voice whose level, referred through the gain chain, stays
+// under its share of half an LSB of the output format can no longer change
+// a sample: retire it instead of running the release ramp down to exactly
+// 0. The share is 1/MAX_VOICES, so every retired tail together stays under
+// the half LSB even with the whole pool retiring at once.
+#define RETIRE_LSB_FRACTION 0.5f
+#define RETIRE_RES_PEAK 2.0f // Allowance for SVF resonance gain
+
+// --- Silence Detection ---
+#define SILENCE_THRESHOLD 1.0e-4f // SVF state magnitude treated as silent
+#define DELAY_QUIET_LEVEL 30      // Delay tap (int16, ~-60dBFS) as silent
+
+// --- Sound Profiles (AudioEngine.cpp, shared with the native renderer) ---
+extern SoundProfile btProfile;
+extern SoundProfile spkProfile;
+
+// --- Engine Inputs (Owned by main.cpp, read by publishParams on the UI core)
+extern Waveform currentWaveform;
+extern bool fxDrive;
+extern bool fxTrem;
+extern bool fxLFO;
+extern int delayMode; // 0=Off, 1=300ms, 2=600ms, 3=900ms, 4=1200ms
+extern float masterVolume;
+extern bool isAudioTestRunning;
+extern bool softRestart; // Same-note retrigger keeps phase + level
+extern float outputLsb;  // One LSB of the active output (engine units)
+
+// Everything publishParams() reads, as one value: the live engine takes it
+// from the globals above, a private engine (benchmark) builds its own
+struct EngineInputs {
+  SynthParameters params;
+  SoundProfile *profile;
+  Waveform waveform;
+  bool fxDrive;
+  bool fxTrem;
+  bool fxLFO;
+  int delayMode;
+  float masterVolume;
+  bool testTone;
+  bool softRestart;
+  float outputLsb;
+  int sampleRate;
+};
+
+// Snapshot of the UI globals (UI core)
+EngineInputs currentEngineInputs();
+
+// --- NOTE EVENTS (UI Core -> Audio Core) ---
+// The UI never touches the voices directly. It posts events which the engine
+// drains at the start of every render block, so triggers are block-accurate
+// and voice allocation/stealing happens entirely on the audio side.
+#define NOTE_EVENT_QUEUE_LEN 128     // Power of two
+#define NOTE_EVENT_MAX_AGE_US 100000 // Drop stale note-ons (output stopped)
+
+enum NoteEventType : uint8_t {
+  EVT_NOTE_ON,           // Allocate (or steal) a voice and trigger it
+  EVT_RELEASE_HELD,      // Touch lifted: release held, unlatched voices
+  EVT_RELEASE_UNLATCHED, // Manual Arp monophony
+  EVT_RELEASE_LATCHED,   // Latched Arp step: release previous latched voice
+  EVT_RELEASE_ALL,       // Unlatch + release everything
+  EVT_ENV_PARAMS         // Live envelope times/rates + waveform
+};
+
+struct NoteEvent {
+  uint32_t time = 0;      // micros() when posted
+  uint32_t touchTime = 0; // Latency probe: touch micros() (0 = not probed)
+  NoteEventType type = EVT_NOTE_ON;
+  VoiceRole role = ROLE_STRUM;
+  uint8_t waveform = WAVE_SAW;
+  int16_t noteIdx = -1;
+  float freq = 0.0f;
+  float pw = 0.5f;
+  float attack = 0.01f;
+  float decay = 0.1f;
+  float sustain = 0.7f;
+  float release = 0.3f;
+};
+
+// --- FILTER COEFFICIENTS ---
+// SVF coefficients resolved off the sample loop. The cutoff clamps and the
+// v3.5 Q-Compensation ladder (waveform x profile) collapse into f and q, so
+// the inner loop is just the multiply-adds and state clamps.
+struct FilterCoeffs {
+  float cutoffHz = 1000.0f;
+  float f = 0.5f;      // Clamped cutoff coefficient
+  float q = 1.0f;      // Damping at resMod = 1.0
+  float res = 0.2f;    // Base resonance (activeParams.filterRes)
+  float qScale = 1.0f; // Combined Q-Compensation multiplier
+
+  void update(float cutoffHz, float fs, float filterRes, Waveform wave,
+              bool isBT);
+  // Damping for a resonance modulation factor (LFO -> Res, control rate)
+  float dampingFor(float resMod) const;
+};
+
+// --- CUTOFF -> COEFFICIENT TABLE ---
+// f = 2 * sin(PI * Fc / Fs) (with the SVF stability clamps) sampled from
+// 0 to Fs/2 and linearly interpolated, so LFO -> Filter can update the
+// cutoff every sample without a sin(). Rebuilt when the sample rate changes.
+#define CUTOFF_TABLE_SIZE 128
+
+struct CutoffTable {
+  float coeff[CUTOFF_TABLE_SIZE + 1];
+  float hzToIndex = 0.0f;
+
+  void build(float fs);
+  float IRAM_ATTR lookup(float hz) const {
+    float pos = hz * hzToIndex;
+    if (pos < 0.0f)
+      pos = 0.0f;
+    if (pos > (float)CUTOFF_TABLE_SIZE - 0.001f)
+      pos = (float)CUTOFF_TABLE_SIZE - 0.001f;
+    int idx = (int)pos;
+    float frac = pos - (float)idx;
+    return coeff[idx] + (coeff[idx + 1] - coeff[idx]) * frac;
+  }
+};
+
+// --- PARAMETER SNAPSHOT (UI Core -> Audio Core) ---
+// Everything the renderer needs besides voices, built on the UI side with
+// derived coefficients already computed. Published through a
+// sequence-counted double buffer and picked up once per render block.
+struct ParamSnapshot {
+  // Filter
+  FilterCoeffs filter;
+
+  // Modulators (increments in cycles per sample)
+  float lfoInc = 0.35f / SAMPLE_RATE;
+  float lfoDepth = 0.0f;
+  LfoType lfoType = LFO_SINE;
+  LfoTarget lfoTarget = TARGET_PITCH;
+  float waveFold = 0.5f;
+  float wowInc = 2.0f / SAMPLE_RATE;
+  float flutterInc = 3.0f / SAMPLE_RATE;
+  float tremInc = 5.0f / SAMPLE_RATE;
+  bool fxLFO = false;
+  bool fxDrive = false;
+  bool fxTrem = false;
+
+  // Mix / FX
+  float masterGain = 1.0f;
+  float drive = 1.0f;
+  float delayFeedback = 0.3f;
+  int delayMode = 0;
+  int delaySamples = 0; // Read offset in downsampled delay taps
+  float masterVolume = 0.8f;
+
+  // Audio Config Test Tone
+  bool testTone = false;
+  float testInc = 2.0f * PI * 440.0f / SAMPLE_RATE;
+
+  // Voices (envelope applied to every non-sparkle voice on each new
+  // snapshot; pulse width is waveFold)
+  float envAttack = 0.01f;
+  float envDecay = 0.1f;
+  float envSustain = 0.7f;
+  float envRelease = 0.3f;
+  bool softRestart = true;
+  float retireLevel = 0.0f; // Per-voice level (mixGain units) to retire
+};
+
+// --- AUDIO ENGINE ---
+// Single render path shared by the DAC and A2DP outputs.
+// render() produces mono float samples (nominal -1.0 to 1.0, not clipped):
+// Modulation -> Voices -> SVF -> Drive -> Delay -> Tremolo -> Volume.
+// Output formats (8-bit DAC, 16-bit Frames) are thin adapters on top.
+class AudioEngine {
+public:
+  // Build a ParamSnapshot from the UI globals (filter coefficient,
+  // modulator rates, FX state) and publish it. UI core only; call after
+  // changing activeParams, FX toggles, profile or activeSampleRate.
+  void publishParams() { publishParams(currentEngineInputs()); }
+  // Same from explicit inputs (leaves the UI globals alone)
+  void publishParams(const EngineInputs &in);
+
+  // Rebuild sample-rate dependent tables (mode switch, audio stopped)
+  void buildTables();
+
+  // Render n samples (any length, processed in AUDIO_BLOCK_SIZE chunks)
+  void IRAM_ATTR render(float *out, int n);
+
+  // Queue a voice event (UI core only). Returns false if the queue is full.
+  bool post(NoteEvent &e);
+
+  uint32_t droppedEvents = 0; // Queue full (UI side)
+
+  // True while the silence fast path is active (no DSP running)
+  bool isIdle() const { return idle; }
+
+  // Optional second-core voice rendering (NULL: single-core). Set once,
+  // before the audio task starts.
+  void setSplit(SplitRender *s) { split = s; }
+
+  // Off: this engine's blocks stay out of the global profiler and latency
+  // probe (private engines, e.g. the benchmark, next to the live one)
+  void setInstrumented(bool on) { instrumented = on; }
+
+  // Polyphony cap: learns the block cost, admits note-ons against it
+  PolyGovernor governor;
+  uint32_t voicesShed = 0;    // Faded out because the limit dropped
+  uint32_t voicesRetired = 0; // Stopped below the output LSB
+  uint32_t voiceSteals() const { return pool.steals; }
+  uint32_t voiceReuses() const { return pool.reuses; }
+
+private:
+  void acquireParams();
+  uint8_t fxKey() const;
+  void processEvents();
+  void shedVoices();
+  bool tailSilent();
+  void renderBlock(float *out, int n);
+  float processFilter(float mixedSample, float f, float q);
+
+  // Parameters (audio-side copy, refreshed at block boundaries)
+  SeqDoubleBuffer<ParamSnapshot> paramBuffer;
+  ParamSnapshot params;
+  uint32_t paramSeq = 0;
+
+  // Filter State (Chamberlin SVF)
+  float svfLow = 0.0f;
+  float svfBand = 0.0f;
+
+  // Voices (allocation lists + active iteration)
+  VoicePool pool;
+  SplitRender *split = NULL;
+  int overLimitBlocks = 0; // Consecutive blocks over the governor limit
+  bool instrumented = true; // Feeds dspProfiler / latencyProbe
+  Waveform lastWave = WAVE_SAW; // Latest note-on / waveform change
+
+  // LFO / Tape Wobble / Tremolo (Control Rate)
+  ModulationEngine modulation;
+  CutoffTable cutoffTable;
+
+  // Delay State
+  // Using int16_t for buffer to save RAM (26KB) + Super Vintage Grit
+  int16_t delayBuffer[MAX_DELAY_LEN];
+  int delayHead = 0;
+  int delayTick = 0;           // For downsampling
+  float delayLpfState = 0.0f; // For feedback damping
+  int delayQuietTaps = 0;     // Consecutive inaudible taps written
+
+  // Silence Fast Path
+  bool idle = false;
+
+  // Audio Config Test Tone
+  float testPhase = 0.0f;
+
+  SpscQueue<NoteEvent, NOTE_EVENT_QUEUE_LEN> noteEvents;
+};
+
+extern AudioEngine audioEngine;
+
+#endif
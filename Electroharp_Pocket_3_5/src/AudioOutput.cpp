@@ -0,0 +1,284 @@
+#include "AudioOutput.h"
+#include "Profiler.h"
+
+AudioOutput audioOutput;
+
+AudioConfigPreset audioPresets[AUDIO_PRESET_COUNT] = {
+    {"Internal DAC", 0, 26, 25, 22,
+     2}, // Mode 2 = DAC. Pins irrelevant but stored.
+    {"MAX98357 Std", 0, 26, 25, 22, 0},
+    {"PCM5102 Std", 0, 26, 25, 22, 0}, // Often same as MAX, but useful label
+    {"Custom 1", 0, 26, 25, 33, 0},
+    {"PT8211 LSB", 0, 26, 25, 22, 1}};
+
+bool AudioOutput::begin(int index, int rate, bool lowLat) {
+  if (index < 0 || index >= AUDIO_PRESET_COUNT)
+    index = 0;
+  if (lock == NULL)
+    lock = xSemaphoreCreateMutex();
+
+  xSemaphoreTake(lock, portMAX_DELAY);
+  stop();
+
+  presetIndex = index;
+  sampleRate = rate;
+  lowLatency = lowLat;
+  bufLen = lowLatency ? LL_QUANTUM : I2S_DMA_BUF_LEN;
+  bufCount = lowLatency ? LL_MIN_BUFS : I2S_DMA_BUF_COUNT;
+  underruns = 0;
+  recoveries = 0;
+  wanted = true;
+
+  bool ok = install();
+  xSemaphoreGive(lock);
+
+  // Report here (caller's task), never from the audio task's recovery path
+  const char *name = audioPresets[presetIndex].name;
+  if (ok)
+    Serial.printf("I2S: %s @ %d Hz (%d x %d frames DMA%s)\n", name,
+                  sampleRate, bufCount, bufLen,
+                  lowLatency ? ", low latency" : "");
+  else
+    Serial.printf("I2S: Driver install failed (%s), retrying\n", name);
+  return ok;
+}
+
+// Install the driver for presetIndex / bufCount x bufLen
+bool AudioOutput::install() {
+  const AudioConfigPreset &p = audioPresets[presetIndex];
+  builtInDac = (p.format == 2);
+  // Built-in DAC is only wired to I2S0
+  port = (builtInDac || p.i2s_num == 0) ? I2S_NUM_0 : I2S_NUM_1;
+
+  i2s_config_t cfg;
+  memset(&cfg, 0, sizeof(cfg));
+  cfg.mode = (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_TX);
+  if (builtInDac)
+    cfg.mode = (i2s_mode_t)(cfg.mode | I2S_MODE_DAC_BUILT_IN);
+  cfg.sample_rate = sampleRate;
+  cfg.bits_per_sample = I2S_BITS_PER_SAMPLE_16BIT;
+  cfg.channel_format = I2S_CHANNEL_FMT_RIGHT_LEFT;
+  // PT8211 is LSB-justified: with 16-bit slots that equals MSB-justified
+  // (no 1-bit WS delay). The built-in DAC also expects MSB framing.
+  cfg.communication_format = (p.format == 0) ? I2S_COMM_FORMAT_STAND_I2S
+                                             : I2S_COMM_FORMAT_STAND_MSB;
+  cfg.intr_alloc_flags = ESP_INTR_FLAG_LEVEL1;
+  cfg.dma_buf_count = bufCount;
+  cfg.dma_buf_len = bufLen;
+  cfg.use_apll = false;
+  cfg.tx_desc_auto_clear = true; // Underrun plays silence, not a stale loop
+
+  if (i2s_driver_install(port, &cfg, I2S_EVENT_QUEUE_LEN, &events) !=
+      ESP_OK) {
+    installFails++;
+    events = NULL;
+    return false;
+  }
+
+  if (builtInDac) {
+    i2s_set_pin(port, NULL);
+    i2s_set_dac_mode(I2S_DAC_CHANNEL_LEFT_EN); // DAC2 = GPIO 26
+  } else {
+    i2s_pin_config_t pins;
+    pins.mck_io_num = I2S_PIN_NO_CHANGE;
+    pins.bck_io_num = p.bck;
+    pins.ws_io_num = p.ws;
+    pins.data_out_num = p.dout;
+    pins.data_in_num = I2S_PIN_NO_CHANGE;
+    i2s_set_pin(port, &pins);
+  }
+  i2s_zero_dma_buffer(port);
+
+  freeBufs = bufCount;
+  primeBufs = bufCount;
+  generation++;
+  running = true;
+  return true;
+}
+
+// Normal-latency ring (the configuration begin() uses with lowLatency off).
+// Caller holds lock.
+void AudioOutput::fallBack() {
+  lowLatency = false;
+  bufLen = I2S_DMA_BUF_LEN;
+  bufCount = I2S_DMA_BUF_COUNT;
+  install();
+}
+
+bool AudioOutput::restart() {
+  if (lock == NULL)
+    return false;
+  xSemaphoreTake(lock, portMAX_DELAY);
+  if (wanted && !running)
+    fallBack();
+  bool ok = running;
+  xSemaphoreGive(lock);
+  return ok;
+}
+
+void AudioOutput::end() {
+  if (lock == NULL)
+    return;
+  xSemaphoreTake(lock, portMAX_DELAY);
+  wanted = false;
+  stop();
+  xSemaphoreGive(lock);
+}
+
+// Caller holds lock
+void AudioOutput::stop() {
+  if (!running)
+    return;
+  running = false;
+  // waitForSpace() blocks on the event queue without the lock: get it out
+  // before the driver deletes the queue (TX_DONE keeps arriving anyway)
+  while (receiving) {
+    i2s_event_t wake;
+    wake.type = I2S_EVENT_MAX;
+    wake.size = 0;
+    xQueueSend(events, &wake, 0);
+    vTaskDelay(1);
+  }
+  if (builtInDac)
+    i2s_set_dac_mode(I2S_DAC_CHANNEL_DISABLE);
+  i2s_driver_uninstall(port); // Also deletes the event queue
+  events = NULL;
+}
+
+// Count TX_DONE events since the last write (non-blocking). Caller holds
+// lock.
+void AudioOutput::checkUnderrun() {
+  i2s_event_t evt;
+  int played = 0;
+  while (xQueueReceive(events, &evt, 0) == pdTRUE) {
+    if (evt.type == I2S_EVENT_TX_DONE)
+      played++;
+  }
+  onPlayed(played);
+}
+
+// Every played buffer frees a slot; if more slots free up than the ring
+// holds, the DMA went around with nothing new to play (auto-clear:
+// silence). Caller holds lock.
+void AudioOutput::onPlayed(int played) {
+  freeBufs += played;
+  if (freeBufs <= bufCount)
+    return;
+  freeBufs = bufCount;
+  if (primeBufs > 0)
+    return; // Start-up: the ring held nothing yet
+
+  underruns++;
+  if (lowLatency && bufCount < LL_MAX_BUFS) {
+    // Grow the ring by one buffer (reinstall: the glitch already happened)
+    bufCount++;
+    recoveries++;
+    stop();
+    if (!install())
+      fallBack(); // Still down: the audio task retries via restart()
+  }
+}
+
+void AudioOutput::write(const float *in, int n) {
+  if (!running)
+    return;
+  xSemaphoreTake(lock, portMAX_DELAY);
+  if (!running) {
+    xSemaphoreGive(lock);
+    return;
+  }
+
+  for (int base = 0; base < n && running; base += bufLen) {
+    int len = n - base;
+    if (len > bufLen)
+      len = bufLen;
+
+    if (events != NULL)
+      checkUnderrun();
+    if (!running)
+      break; // Recovery reinstall failed
+
+    PROF_DECLARE(profT);
+    for (int i = 0; i < len; i++) {
+      float s = in[base + i];
+      if (s > 1.0f)
+        s = 1.0f;
+      if (s < -1.0f)
+        s = -1.0f;
+
+      int16_t out;
+      if (builtInDac) {
+        // DAC uses the top 8 bits, unsigned (same scale as the old ISR)
+        out = (int16_t)((uint16_t)(128 + (int)(s * 127.0f)) << 8);
+      } else {
+        out = (int16_t)(s * 30000.0f);
+      }
+      frameBuf[i * 2] = out;
+      frameBuf[i * 2 + 1] = out;
+    }
+    PROF_RECORD(PROF_OUT_SPK, profCycles() - profT);
+
+    size_t written = 0;
+    i2s_write(port, frameBuf, len * 2 * sizeof(int16_t), &written,
+              portMAX_DELAY);
+    if (freeBufs > 0)
+      freeBufs--;
+    if (primeBufs > 0)
+      primeBufs--;
+  }
+
+  xSemaphoreGive(lock);
+}
+
+// While priming, fill the ring straight away. Caller holds lock.
+int AudioOutput::wakeNeed() const {
+  int need = (primeBufs > 0) ? 1 : wakeWatermark;
+  if (need >= bufCount)
+    need = bufCount - 1;
+  return need;
+}
+
+bool AudioOutput::waitForSpace(TickType_t timeout) {
+  if (!running)
+    return false;
+  xSemaphoreTake(lock, portMAX_DELAY);
+  if (!running || events == NULL) {
+    xSemaphoreGive(lock);
+    return false;
+  }
+
+  // Behind (or priming): the backlog is already queued, render at once
+  checkUnderrun();
+  if (running && freeBufs >= wakeNeed()) {
+    xSemaphoreGive(lock);
+    return true;
+  }
+
+  // Block for the next TX_DONE with the lock released, so begin()/end()
+  // on the UI core never wait on playback
+  QueueHandle_t q = events;
+  uint32_t gen = generation;
+  receiving = true;
+  xSemaphoreGive(lock);
+
+  i2s_event_t evt;
+  bool got = xQueueReceive(q, &evt, timeout) == pdTRUE;
+  receiving = false;
+
+  xSemaphoreTake(lock, portMAX_DELAY);
+  // Driver restarted meanwhile: q is gone, the event was stop()'s wake
+  bool same = running && generation == gen;
+  if (got && same && evt.type == I2S_EVENT_TX_DONE)
+    onPlayed(1);
+  bool ready = same && freeBufs >= wakeNeed();
+  xSemaphoreGive(lock);
+  return ready;
+}
+
+void AudioOutput::setWatermark(int buffers) {
+  if (buffers < 1)
+    buffers = 1;
+  if (buffers > LL_MAX_BUFS - 1)
+    buffers = LL_MAX_BUFS - 1;
+  wakeWatermark = buffers;
+}
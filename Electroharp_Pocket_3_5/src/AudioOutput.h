@@ -0,0 +1,119 @@
+#ifndef AUDIO_OUTPUT_H
+#define AUDIO_OUTPUT_H
+
+#include "Config.h"
+#include <Arduino.h>
+#include <driver/i2s.h>
+
+// --- AUDIO CONFIG DATA ---
+struct AudioConfigPreset {
+  const char *name;
+  int i2s_num;
+  int bck;
+  int ws;
+  int dout;
+  int format; // 0=I2S_Norm, 1=LSB (PT8211), 2=DAC_INT
+};
+
+#define AUDIO_PRESET_COUNT 5
+extern AudioConfigPreset audioPresets[AUDIO_PRESET_COUNT];
+
+// --- I2S DMA Settings ---
+#define I2S_DMA_BUF_COUNT 4
+#define I2S_DMA_BUF_LEN 256 // Frames per DMA buffer (~11.6ms @ 22050Hz)
+#define I2S_EVENT_QUEUE_LEN 16
+
+// --- Low-Latency Mode ---
+// The DMA ring always plays its full length (count x len) ahead of the
+// writer, so latency is set by the ring, not by how early we render.
+// Low-latency mode renders a small fixed quantum and starts with a short
+// ring. Underruns step the ring up by one buffer (never down).
+#define LL_QUANTUM 64  // Frames per render / DMA buffer (~2.9ms)
+#define LL_MIN_BUFS 3  // Starting fill (~8.7ms)
+#define LL_MAX_BUFS 12 // Ceiling (~35ms)
+// A failed reinstall falls back to the normal-latency ring; if the driver
+// still won't start, the audio task retries at this interval
+#define I2S_RETRY_MS 500
+
+// --- SPEAKER OUTPUT (I2S DMA) ---
+// Replaces the 22kHz timer ISR. "Internal DAC" runs I2S0 in built-in DAC
+// mode (GPIO 26), all other presets drive an external I2S DAC/amp.
+// write() blocks in i2s_write until a DMA buffer completes, so the audio
+// task sleeps between buffers instead of polling.
+class AudioOutput {
+public:
+  // (Re)start output for a preset. Returns false if the driver failed.
+  // lowLatency: LL_QUANTUM buffers, fill starts at LL_MIN_BUFS.
+  bool begin(int presetIndex, int sampleRate, bool lowLatency);
+  // Stop output and release the I2S peripheral (needed before A2DP)
+  void end();
+  bool isRunning() const { return running; }
+  // Audio task: output should run but the driver is down (install failed)
+  bool needsRestart() const { return wanted && !running; }
+  // Audio task: reinstall with the normal-latency ring. Returns isRunning().
+  bool restart();
+
+  // Write n mono samples (-1.0 to 1.0). Blocks until DMA has room.
+  void write(const float *in, int n);
+
+  // Sleep until the I2S ISR reports (TX_DONE) a played buffer. Returns
+  // true when one quantum should be rendered now: at least the wake
+  // watermark of DMA buffers are free. One quantum per call; queued events
+  // are the backlog. Blocks without holding the driver lock.
+  bool waitForSpace(TickType_t timeout);
+
+  // Free buffers needed before rendering (1..ring-1). Higher renders closer
+  // to playback (lower latency, less margin); in steady state it is still
+  // one quantum per TX_DONE event.
+  void setWatermark(int buffers);
+  int watermark() const { return wakeWatermark; }
+
+  // Frames per DMA buffer: render this many per write()
+  int quantum() const { return bufLen; }
+  // DMA ring length in frames (output latency after write returns)
+  int fillFrames() const { return bufLen * bufCount; }
+  bool isLowLatency() const { return lowLatency; }
+  // One output LSB in engine units (8-bit built-in DAC / 16-bit I2S)
+  float lsb() const { return builtInDac ? 1.0f / 127.0f : 1.0f / 30000.0f; }
+
+  int presetIndex = -1;
+
+  // Underrun Telemetry (audio task writes, UI reads)
+  volatile uint32_t underruns = 0;    // Buffers the DMA played with no data
+  volatile uint32_t recoveries = 0;   // Fill increases (low-latency mode)
+  volatile uint32_t installFails = 0; // Driver installs that failed
+
+private:
+  bool install(); // Caller holds lock. Silent: also runs on the audio task
+  void fallBack();
+  void stop();
+  void checkUnderrun();
+  void onPlayed(int buffers);
+  int wakeNeed() const;
+
+  SemaphoreHandle_t lock = NULL; // Guards driver against begin/end on Core 1
+  volatile bool running = false;
+  volatile bool wanted = false; // Between begin() and end()
+  bool builtInDac = false;
+  bool lowLatency = false;
+  int sampleRate = SAMPLE_RATE;
+  i2s_port_t port = I2S_NUM_0;
+  int bufLen = I2S_DMA_BUF_LEN;
+  int bufCount = I2S_DMA_BUF_COUNT;
+
+  // Underrun detection from the driver's TX_DONE events
+  QueueHandle_t events = NULL;
+  int freeBufs = 0;   // Played buffers not yet refilled
+  int primeBufs = 0;  // Writes left before the ring holds real audio
+
+  // waitForSpace() blocked on events without the lock, and the install it
+  // blocked under (the queue may be deleted and reallocated meanwhile)
+  volatile bool receiving = false;
+  uint32_t generation = 0;
+  volatile int wakeWatermark = 1;
+  int16_t frameBuf[I2S_DMA_BUF_LEN * 2]; // Interleaved L/R
+};
+
+extern AudioOutput audioOutput;
+
+#endif
@@ -0,0 +1,140 @@
+#ifndef AUDIO_RING_H
+#define AUDIO_RING_H
+
+#include "Platform.h"
+#include <atomic>
+
+// --- LOCK-FREE SPSC AUDIO RING ---
+// Bulk sample FIFO between one producer task and one consumer (task or
+// callback), same rules as SpscQueue: N is a power of two, indices run free
+// and are masked on access, acquire/release atomics, no locks.
+// Each side keeps its own telemetry so glitches can be attributed:
+// consumer-side underruns / starvation (renderer too slow) vs producer-side
+// overruns / high water (consumer stalled, e.g. SPI/TFT contention).
+struct AudioRingStats {
+  uint32_t underruns = 0;       // Reads that came up short
+  uint32_t missing = 0;         // Items the consumer had to make up
+  uint32_t overruns = 0;        // Writes that did not fit
+  uint32_t lowWater = 0;        // Lowest fill seen before a read
+  uint32_t highWater = 0;       // Highest fill after a write
+  uint32_t longestStarveUs = 0; // Longest run of consecutive short reads
+};
+
+template <typename T, uint32_t N> class AudioRing {
+  static_assert(N > 0 && (N & (N - 1)) == 0, "N must be a power of two");
+
+public:
+  AudioRing() { resetStats(); }
+
+  // Producer: copy up to n items. Returns the number written.
+  uint32_t IRAM_ATTR write(const T *in, uint32_t n) {
+    uint32_t h = head.load(std::memory_order_relaxed);
+    uint32_t free = N - (h - tail.load(std::memory_order_acquire));
+    if (n > free) {
+      stats.overruns++;
+      n = free;
+    }
+    copyIn(h, in, n);
+    head.store(h + n, std::memory_order_release);
+
+    uint32_t level = (h + n) - tail.load(std::memory_order_relaxed);
+    if (level > stats.highWater)
+      stats.highWater = level;
+    return n;
+  }
+
+  // Consumer: copy up to n items. Returns the number read; the caller
+  // makes up the rest (silence / hold).
+  uint32_t IRAM_ATTR read(T *out, uint32_t n) {
+    uint32_t t = tail.load(std::memory_order_relaxed);
+    uint32_t avail = head.load(std::memory_order_acquire) - t;
+    if (avail < stats.lowWater)
+      stats.lowWater = avail;
+
+    uint32_t got = (n < avail) ? n : avail;
+    copyOut(t, out, got);
+    tail.store(t + got, std::memory_order_release);
+
+    // Starvation: time from the first short read to the next full one
+    if (got < n) {
+      stats.underruns++;
+      stats.missing += n - got;
+      if (!starving) {
+        starving = true;
+        starveStart = micros();
+      }
+    } else if (starving) {
+      starving = false;
+      uint32_t us = micros() - starveStart;
+      if (us > stats.longestStarveUs)
+        stats.longestStarveUs = us;
+    }
+    return got;
+  }
+
+  // Fill level / free space (exact when called from the matching end)
+  uint32_t fill() const {
+    return head.load(std::memory_order_acquire) -
+           tail.load(std::memory_order_acquire);
+  }
+  uint32_t space() const { return N - fill(); }
+  // Running totals (free-running positions, wrap at 2^32)
+  uint32_t written() const { return head.load(std::memory_order_acquire); }
+  uint32_t consumed() const { return tail.load(std::memory_order_acquire); }
+  static constexpr uint32_t capacity() { return N; }
+
+  // Drop the contents. Only while both ends are stopped.
+  void clear() {
+    head.store(0, std::memory_order_relaxed);
+    tail.store(0, std::memory_order_relaxed);
+    starving = false;
+  }
+
+  // Telemetry (UI core reads; word-sized fields, a torn snapshot is fine)
+  const AudioRingStats &getStats() const { return stats; }
+  void resetStats() {
+    stats = AudioRingStats();
+    stats.lowWater = N;
+  }
+
+private:
+  void copyIn(uint32_t h, const T *in, uint32_t n) {
+    uint32_t pos = h & (N - 1);
+    uint32_t first = (n < N - pos) ? n : N - pos;
+    memcpy(&buf[pos], in, first * sizeof(T));
+    memcpy(&buf[0], in + first, (n - first) * sizeof(T));
+  }
+
+  void copyOut(uint32_t t, T *out, uint32_t n) {
+    uint32_t pos = t & (N - 1);
+    uint32_t first = (n < N - pos) ? n : N - pos;
+    memcpy(out, &buf[pos], first * sizeof(T));
+    memcpy(out + first, &buf[0], (n - first) * sizeof(T));
+  }
+
+  T buf[N];
+  std::atomic<uint32_t> head{0}; // Written by producer only
+  std::atomic<uint32_t> tail{0}; // Written by consumer only
+
+  AudioRingStats stats;
+  bool starving = false; // Consumer only
+  uint32_t starveStart = 0;
+};
+
+// Print one ring's counters ("stats" console). rate: items per second.
+template <typename T, uint32_t N>
+void printAudioRing(void (*emit)(const char *line), const char *name,
+                    const AudioRing<T, N> &ring, int rate) {
+  const AudioRingStats &s = ring.getStats();
+  char line[160];
+  snprintf(line, sizeof(line),
+           "%s: fill %u/%u (%.1f ms) | low %u high %u | underruns %u "
+           "(%u missing) | overruns %u | starve max %u us",
+           name, (unsigned)ring.fill(), (unsigned)N,
+           ring.fill() * 1000.0f / rate, (unsigned)s.lowWater,
+           (unsigned)s.highWater, (unsigned)s.underruns, (unsigned)s.missing,
+           (unsigned)s.overruns, (unsigned)s.longestStarveUs);
+  emit(line);
+}
+
+#endif
@@ -0,0 +1,175 @@
+#include "Benchmark.h"
+#include "AudioEngine.h"
+#include "Upsampler.h"
+#include <new>
+
+// --- Timing ---
+#ifdef ARDUINO
+static inline uint32_t benchCycles() { return ESP.getCycleCount(); }
+static inline uint64_t benchNanos() { return 0; }
+#else
+static inline uint32_t benchCycles() { return 0; }
+static inline uint64_t benchNanos() {
+  return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+#endif
+
+// --- Matrix ---
+struct BenchFx {
+  bool drive;
+  bool trem;
+  int delay;
+  bool lfo;
+};
+
+static const BenchFx benchFx[] = {
+    {false, false, 0, false}, // Dry
+    {true, false, 0, false},  // Drive
+    {false, true, 0, false},  // Tremolo
+    {false, false, 2, false}, // Delay (600ms)
+    {false, false, 0, true},  // LFO -> Filter (per-sample cutoff)
+    {true, true, 2, true}     // Everything
+};
+#define BENCH_FX_COUNT (int)(sizeof(benchFx) / sizeof(benchFx[0]))
+
+static const char *benchWaveNames[4] = {"saw", "square", "sine", "tri"};
+
+// Fixed parameters (firmware defaults) so runs compare across builds
+static const SynthParameters benchParams = {
+    3500.0f, 0.70f, 0.50f, 0.50f, 0.05f,         2.0f, 0.35f,
+    0.30f,   0.20f, 5.0f,  LFO_SINE, TARGET_FILTER, 4};
+
+// Release whatever the previous row left sounding (fast release)
+static void benchSilence(AudioEngine *engine, Waveform wave, float *block) {
+  NoteEvent e;
+  e.type = EVT_ENV_PARAMS;
+  e.attack = 0.001f;
+  e.release = 0.001f;
+  e.waveform = wave;
+  engine->post(e);
+  e.type = EVT_RELEASE_ALL;
+  engine->post(e);
+  for (int i = 0; i < 4; i++)
+    engine->render(block, AUDIO_BLOCK_SIZE);
+}
+
+bool runDspBenchmark(BenchEmit emit) {
+  AudioEngine *engine = new (std::nothrow) AudioEngine();
+  if (engine == NULL)
+    return false;
+  engine->governor.setEnabled(false); // Measure every voice count
+  engine->setInstrumented(false);       // Live stats stay the live engine's
+
+  // Own inputs: the live engine keeps rendering from the UI globals
+  EngineInputs in = currentEngineInputs();
+  in.params = benchParams;
+  in.masterVolume = 0.8f;
+  in.testTone = false;
+  in.softRestart = false;
+  engine->buildTables();
+
+  HalfBandUpsampler upsampler;
+  upsampler.reset();
+  float block[AUDIO_BLOCK_SIZE];
+  float up[AUDIO_BLOCK_SIZE * 2];
+  char line[128];
+
+  emit("target,rate,wave,voices,drive,trem,delay,lfo,ns_per_sample,"
+       "cycles_per_sample");
+
+  for (int r = 0; r < 2; r++) {
+    bool isBT = (r == 1);
+    int rate = isBT ? SAMPLE_RATE * 2 : SAMPLE_RATE;
+    in.profile = isBT ? &btProfile : &spkProfile;
+
+    for (int w = 0; w < 4; w++) {
+      Waveform wave = (Waveform)w;
+      in.waveform = wave;
+      for (int v = 1; v <= MAX_VOICES; v++) {
+        for (int x = 0; x < BENCH_FX_COUNT; x++) {
+          const BenchFx &fx = benchFx[x];
+          in.fxDrive = fx.drive;
+          in.fxTrem = fx.trem;
+          in.delayMode = fx.delay;
+          in.fxLFO = fx.lfo;
+
+          benchSilence(engine, wave, block);
+          engine->publishParams(in);
+
+          // Sustained voices across the range (latched: no poly limit)
+          NoteEvent e;
+          e.type = EVT_ENV_PARAMS;
+          e.attack = 0.001f;
+          e.release = benchParams.releaseTime;
+          e.waveform = wave;
+          engine->post(e);
+          for (int i = 0; i < v; i++) {
+            NoteEvent n;
+            n.type = EVT_NOTE_ON;
+            n.role = ROLE_LATCHED_ARP;
+            n.waveform = wave;
+            n.freq = 65.406f * powf(2.0f, (i * 5) / 12.0f); // C2 in 4ths
+            if (n.freq > 3200.0f)
+              n.freq = 3200.0f;
+            n.noteIdx = 12 + i * 5;
+            n.pw = benchParams.waveFold;
+            n.attack = 0.001f;
+            n.decay = 0.1f;
+            n.sustain = 0.7f;
+            n.release = benchParams.releaseTime;
+            engine->post(n);
+          }
+
+          // Warm up past the attack (and fill the delay line a little)
+          for (int i = 0; i < 8; i++)
+            engine->render(block, AUDIO_BLOCK_SIZE);
+
+          uint32_t bestCycles = 0xFFFFFFFF;
+          uint64_t bestNanos = (uint64_t)-1;
+          for (int rep = 0; rep < BENCH_REPEATS; rep++) {
+            uint32_t c0 = benchCycles();
+            uint64_t t0 = benchNanos();
+            for (int s = 0; s < BENCH_SAMPLES; s += AUDIO_BLOCK_SIZE) {
+              engine->render(block, AUDIO_BLOCK_SIZE);
+              if (isBT)
+                upsampler.process(block, up, AUDIO_BLOCK_SIZE);
+            }
+            uint32_t c = benchCycles() - c0;
+            uint64_t t = benchNanos() - t0;
+            if (c < bestCycles)
+              bestCycles = c;
+            if (t < bestNanos)
+              bestNanos = t;
+          }
+
+          int outSamples = isBT ? BENCH_SAMPLES * 2 : BENCH_SAMPLES;
+          float cyclesPer = (float)bestCycles / outSamples;
+#ifdef ARDUINO
+          float nsPer = cyclesPer * 1000.0f / (float)getCpuFrequencyMhz();
+          const char *target = "esp32";
+#else
+          float nsPer = (float)bestNanos / outSamples;
+          const char *target = "host";
+#endif
+          if (cyclesPer > 0.0f)
+            snprintf(line, sizeof(line), "%s,%d,%s,%d,%d,%d,%d,%d,%.1f,%.1f",
+                     target, rate, benchWaveNames[w], v, fx.drive, fx.trem,
+                     fx.delay, fx.lfo, nsPer, cyclesPer);
+          else
+            snprintf(line, sizeof(line), "%s,%d,%s,%d,%d,%d,%d,%d,%.1f,",
+                     target, rate, benchWaveNames[w], v, fx.drive, fx.trem,
+                     fx.delay, fx.lfo, nsPer);
+          emit(line);
+#ifdef ARDUINO
+          delay(1); // Let the UI core's other tasks run between rows
+#endif
+        }
+      }
+    }
+  }
+
+  delete engine;
+  return true;
+}
@@ -0,0 +1,21 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include "Platform.h"
+
+// --- DSP BENCHMARK ---
+// Renders a fixed workload through a private AudioEngine for every
+// Waveform x 1..MAX_VOICES x FX set x output rate and emits one CSV row each:
+//   target,rate,wave,voices,drive,trem,delay,lfo,ns_per_sample,cycles_per_sample
+// 44100 rows include the 2x upsampler and are per output sample.
+// Device: CCOUNT cycles (serial "bench"). Host: ns only (env:native_bench).
+#define BENCH_SAMPLES 1024 // Timed engine samples per repeat
+#define BENCH_REPEATS 3    // Best of N (filters interrupts / preemption)
+
+typedef void (*BenchEmit)(const char *line);
+
+// Blocks until the whole matrix is done (~1 min on the ESP32).
+// Returns false if the engine could not be allocated.
+bool runDspBenchmark(BenchEmit emit);
+
+#endif
@@ -1,7 +1,7 @@
 #ifndef CONFIG_H
 #define CONFIG_H
 
-#include <Arduino.h>
+#include "Platform.h"
 
 // --- Pin Definitions ---
 // Display Pins (ST7796 via PlatformIO build_flags)
@@ -25,9 +25,13 @@
 #define LDR_PIN 34
 
 // --- Audio Settings ---
-#define SAMPLE_RATE 22050 // Matched to Augment 2.8 for stability
-#define MAX_VOICES 18     // Increased per user request (was 12)
+#define SAMPLE_RATE 22050     // Matched to Augment 2.8 for stability
+#define BT_SAMPLE_RATE 44100  // A2DP stream (2x upsampled)
+#define MAX_VOICES 24         // Pool size; the governor caps by measured cost
+#define SINGLE_CORE_VOICES 18 // Ceiling while voices render on one core
 #define SAW_MAX 255
+#define AUDIO_BLOCK_SIZE 32   // Samples per render block (voices + FX)
+#define GOVERNOR_HEADROOM 30  // Default % of the render budget kept free
 
 // --- UI Settings ---
 #define SCREEN_WIDTH 480
@@ -0,0 +1,156 @@
+#include "Governor.h"
+#include "Profiler.h"
+
+// Priors (fraction of the budget) until a term has been measured
+#define GOV_PRIOR_BASE 0.15f
+#define GOV_PRIOR_VOICE 0.035f
+
+PolyGovernor::PolyGovernor() {}
+
+void PolyGovernor::setRate(int sampleRate) {
+  if (sampleRate <= 0)
+    sampleRate = SAMPLE_RATE;
+  budget = (float)profCyclesPerSecond() / (float)sampleRate;
+}
+
+void PolyGovernor::setHeadroom(int pct) {
+  if (pct < 10)
+    pct = 10;
+  if (pct > 60)
+    pct = 60;
+  headroomPct = pct;
+}
+
+// Fast rise, slow fall: a cost rise is believed at once, a lucky
+// (cache-warm) block only slowly. A lone outlier is a pre-empted or
+// interrupt-hit block, not a cost: only a run of them gets through.
+void IRAM_ATTR PolyGovernor::track(GovCost &cost, float sample) {
+  if (cost.avg == 0.0f) {
+    cost.avg = sample;
+    return;
+  }
+  if (sample > cost.avg * GOV_SPIKE) {
+    if (cost.spikes < GOV_SPIKE_BLOCKS)
+      cost.spikes++;
+    if (cost.spikes < GOV_SPIKE_BLOCKS)
+      return;
+  } else {
+    cost.spikes = 0;
+  }
+
+  if (sample > cost.avg)
+    cost.avg += (sample - cost.avg) * GOV_RISE;
+  else
+    cost.avg += (sample - cost.avg) * GOV_FALL;
+}
+
+// Per-voice cost of a waveform in a render mode. Until measured: split
+// falls back to the single-core cost (conservative), that to the prior.
+float IRAM_ATTR PolyGovernor::voiceCost(int mode, int wave) const {
+  float c = voicePerSample[mode][wave].avg;
+  if (c == 0.0f && mode == 1)
+    c = voicePerSample[0][wave].avg;
+  return (c == 0.0f) ? budget * GOV_PRIOR_VOICE : c;
+}
+
+void IRAM_ATTR PolyGovernor::learnBlock(uint8_t fx, Waveform wave,
+                                        const uint8_t *waveVoices, int n,
+                                        bool splitBlock, uint32_t voiceCycles,
+                                        uint32_t blockCycles) {
+  if (n <= 0)
+    return;
+  fx &= GOV_FX_KEYS - 1;
+  lastFx = fx;
+  lastWave = wave;
+  splitMode = splitBlock;
+
+  uint32_t baseCycles =
+      (blockCycles > voiceCycles) ? blockCycles - voiceCycles : 0;
+  track(basePerSample[fx], (float)baseCycles / n);
+
+  // Split the voice loop by what each voice rendered: scale the estimates
+  // of the present waveforms by measured / predicted (a one-waveform block
+  // yields that waveform's cost directly)
+  int mode = splitBlock ? 1 : 0;
+  float expected = 0.0f;
+  for (int w = 0; w < 4; w++)
+    expected += waveVoices[w] * voiceCost(mode, w);
+  if (expected > 0.0f) {
+    float ratio = ((float)voiceCycles / n) / expected;
+    for (int w = 0; w < 4; w++) {
+      if (waveVoices[w] > 0)
+        track(voicePerSample[mode][w], voiceCost(mode, w) * ratio);
+    }
+  }
+
+  float load = ((float)blockCycles / n + outPerSample.avg) / budget;
+  loadAvg = loadAvg * 0.9f + load * 0.1f;
+}
+
+void IRAM_ATTR PolyGovernor::learnOutput(uint32_t cycles, int n) {
+  if (n > 0)
+    track(outPerSample, (float)cycles / n);
+}
+
+float IRAM_ATTR PolyGovernor::predict(uint8_t fx, Waveform wave,
+                                      int voices) const {
+  float base = basePerSample[fx & (GOV_FX_KEYS - 1)].avg;
+  if (base == 0.0f)
+    base = budget * GOV_PRIOR_BASE;
+  return base + outPerSample.avg + voiceCost(splitMode ? 1 : 0, wave) * voices;
+}
+
+int IRAM_ATTR PolyGovernor::voiceLimit(uint8_t fx, Waveform wave) const {
+  if (!enabled)
+    return MAX_VOICES;
+
+  float target = budget * (100 - headroomPct) * 0.01f;
+  float fixed = predict(fx, wave, 0);
+  float perVoice = predict(fx, wave, 1) - fixed;
+  int limit = (perVoice > 0.0f) ? (int)((target - fixed) / perVoice) : 0;
+
+  int ceiling = splitMode ? MAX_VOICES : SINGLE_CORE_VOICES;
+  if (limit < GOV_MIN_VOICES)
+    limit = GOV_MIN_VOICES;
+  if (limit > ceiling)
+    limit = ceiling;
+  return limit;
+}
+
+void PolyGovernor::print(void (*emit)(const char *line)) {
+  static const char *waveNames[4] = {"saw", "square", "sine", "tri"};
+  char line[96];
+
+  snprintf(line, sizeof(line),
+           "governor: %s | headroom %d%% | limit %d | load %d%%",
+           enabled ? "on" : "off", headroomPct, currentLimit(),
+           (int)(loadAvg * 100.0f));
+  emit(line);
+
+  // Costs as % of the real-time budget per sample (-- = not measured)
+  for (int w = 0; w < 4; w++) {
+    char cost[2][8];
+    for (int m = 0; m < 2; m++) {
+      float c = voicePerSample[m][w].avg;
+      if (c > 0.0f)
+        snprintf(cost[m], sizeof(cost[m]), "%5.2f%%", c * 100.0f / budget);
+      else
+        snprintf(cost[m], sizeof(cost[m]), "   -- ");
+    }
+    snprintf(line, sizeof(line), "  voice %-6s %s  split %s", waveNames[w],
+             cost[0], cost[1]);
+    emit(line);
+  }
+  for (int k = 0; k < GOV_FX_KEYS; k++) {
+    if (basePerSample[k].avg == 0.0f)
+      continue;
+    snprintf(line, sizeof(line), "  base  %c%c%c%c   %5.2f%%",
+             (k & GOV_FX_DRIVE) ? 'D' : '-', (k & GOV_FX_TREM) ? 'T' : '-',
+             (k & GOV_FX_DELAY) ? 'E' : '-', (k & GOV_FX_LFO) ? 'L' : '-',
+             basePerSample[k].avg * 100.0f / budget);
+    emit(line);
+  }
+  snprintf(line, sizeof(line), "  output       %5.2f%%",
+           outPerSample.avg * 100.0f / budget);
+  emit(line);
+}
@@ -0,0 +1,103 @@
+#ifndef GOVERNOR_H
+#define GOVERNOR_H
+
+#include "Config.h"
+#include "Platform.h"
+#include "SynthVoice.h"
+
+// --- PREDICTIVE POLYPHONY GOVERNOR ---
+// Learns what the render path costs and admits a new voice only if the
+// predicted block cost still leaves the headroom target free:
+//   cost/sample = base[fx] + output + voices * perVoice[waveform]
+// base   : everything outside the voice loop (events, modulation, SVF, FX),
+//          keyed by the active FX set
+// output : format conversion (DMA adapter / A2DP upsampler)
+// voice  : voice loop cost per voice, per waveform the voice rendered
+//          (sparkles always render sine). A mixed block scales each
+//          present waveform by measured / predicted. Kept per render mode:
+//          a split block (second core) costs less wall-clock per voice, and
+//          backoffs switch modes, so the two never share an estimate.
+// All terms are EWMAs of the profiler's cycle counter over real blocks
+// (fast rise, slow fall), so the cap tracks FX and waveform changes before
+// the load climbs instead of reacting after an underrun. A block costing
+// more than GOV_SPIKE x the estimate (pre-empted, interrupt burst) is
+// ignored unless GOV_SPIKE_BLOCKS of them arrive in a row.
+// Admission prices every voice at the note's waveform.
+#define GOV_FX_KEYS 16     // Drive / Tremolo / Delay / LFO combinations
+#define GOV_MIN_VOICES 4   // Never cap below this
+#define GOV_RISE 0.25f     // EWMA weight when a cost goes up
+#define GOV_FALL 0.03f     // EWMA weight when a cost goes down
+#define GOV_SPIKE 2.0f     // Outlier: sample above this x the estimate
+#define GOV_SPIKE_BLOCKS 3 // Outliers in a row that count as a real change
+
+enum GovFx : uint8_t {
+  GOV_FX_DRIVE = 1,
+  GOV_FX_TREM = 2,
+  GOV_FX_DELAY = 4,
+  GOV_FX_LFO = 8
+};
+
+// One learned cost (cycles per sample)
+struct GovCost {
+  float avg = 0.0f;   // 0 = not measured yet
+  uint8_t spikes = 0; // Consecutive outlier samples
+};
+
+class PolyGovernor {
+public:
+  PolyGovernor();
+
+  // Engine sample rate (budget per sample). Audio stopped.
+  void setRate(int sampleRate);
+
+  // Off: admit up to MAX_VOICES (host renders, benchmark)
+  void setEnabled(bool on) { enabled = on; }
+  bool isEnabled() const { return enabled; }
+
+  // UI core: % of each block period kept free (10 - 60)
+  void setHeadroom(int pct);
+  int headroom() const { return headroomPct; }
+
+  // Audio core: one rendered block. wave: the note waveform (telemetry),
+  // waveVoices: voices rendered per Waveform during the loop, splitBlock:
+  // the voices were rendered on both cores. The mode of the last block
+  // prices admissions and shedding; single-core caps at SINGLE_CORE_VOICES.
+  void learnBlock(uint8_t fx, Waveform wave, const uint8_t *waveVoices, int n,
+                  bool splitBlock, uint32_t voiceCycles,
+                  uint32_t blockCycles);
+  // Audio core: output conversion for n engine samples
+  void learnOutput(uint32_t cycles, int n);
+  // Audio core: silence fast path (load decays, costs are kept)
+  void idleBlock() { loadAvg *= 0.9f; }
+
+  // Predicted cycles per sample with the given voice count
+  float predict(uint8_t fx, Waveform wave, int voices) const;
+  // Largest voice count that keeps the headroom target
+  int voiceLimit(uint8_t fx, Waveform wave) const;
+  // Limit for the last rendered configuration (telemetry)
+  int currentLimit() const { return voiceLimit(lastFx, lastWave); }
+
+  // Measured load (render + output) / real time, smoothed
+  float load() const { return loadAvg; }
+
+  void print(void (*emit)(const char *line));
+
+private:
+  static void track(GovCost &cost, float sample);
+  float voiceCost(int mode, int wave) const;
+
+  bool enabled = true;
+  bool splitMode = false; // Last rendered block split across both cores
+  volatile int headroomPct = GOVERNOR_HEADROOM;
+  float budget = 1.0f; // Cycles per sample in real time
+
+  GovCost basePerSample[GOV_FX_KEYS];
+  GovCost voicePerSample[2][4]; // [split][Waveform]
+  GovCost outPerSample;
+  float loadAvg = 0.0f;
+
+  uint8_t lastFx = 0;
+  Waveform lastWave = WAVE_SAW;
+};
+
+#endif
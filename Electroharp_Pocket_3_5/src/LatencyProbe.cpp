@@ -0,0 +1,117 @@
+#include "LatencyProbe.h"
+
+LatencyProbe latencyProbe;
+
+// --- HISTOGRAM ---
+void LatencyHistogram::clear() {
+  memset(bins, 0, sizeof(bins));
+  count = 0;
+  minUs = 0xFFFFFFFF;
+  maxUs = 0;
+}
+
+void LatencyHistogram::add(uint32_t us) {
+  uint32_t b = us / LATENCY_BIN_US;
+  if (b >= LATENCY_BINS)
+    b = LATENCY_BINS - 1;
+  bins[b]++;
+  count++;
+  if (us < minUs)
+    minUs = us;
+  if (us > maxUs)
+    maxUs = us;
+}
+
+uint32_t LatencyHistogram::percentile(int pct) const {
+  if (count == 0)
+    return 0;
+  uint32_t target = (count * (uint32_t)pct + 99) / 100;
+  uint32_t seen = 0;
+  for (int b = 0; b < LATENCY_BINS; b++) {
+    seen += bins[b];
+    if (seen >= target) {
+      uint32_t edge = (uint32_t)(b + 1) * LATENCY_BIN_US;
+      return (edge < maxUs) ? edge : maxUs;
+    }
+  }
+  return maxUs;
+}
+
+// --- PROBE ---
+LatencyProbe::LatencyProbe() {
+  for (int s = 0; s < LAT_SEGMENT_COUNT; s++)
+    hist[s].clear();
+}
+
+// A stamped note-on was triggered in the block being rendered
+void IRAM_ATTR LatencyProbe::noteStarted(uint32_t touchTime) {
+  if (state != PROBE_IDLE)
+    return; // One strum in flight at a time
+  probeTouch = touchTime;
+  state = PROBE_STARTED;
+}
+
+void IRAM_ATTR LatencyProbe::blockRendered() {
+  if (state != PROBE_STARTED)
+    return;
+  probeRender = micros();
+  markSet = false;
+  state = PROBE_RENDERED;
+}
+
+void IRAM_ATTR LatencyProbe::setOutputMark(uint32_t written) {
+  if (state != PROBE_RENDERED || markSet)
+    return;
+  outputMark = written;
+  markSet = true;
+}
+
+void IRAM_ATTR LatencyProbe::handedOff(uint32_t consumed) {
+  if (state == PROBE_RENDERED &&
+      (!markSet || (int32_t)(consumed - outputMark) < 0))
+    return; // Still queued in the ring
+  handedOff();
+}
+
+void IRAM_ATTR LatencyProbe::handedOff() {
+  if (resetPending) {
+    for (int s = 0; s < LAT_SEGMENT_COUNT; s++)
+      hist[s].clear();
+    resetPending = false;
+  }
+  if (state != PROBE_RENDERED)
+    return;
+
+  uint32_t now = micros();
+  hist[LAT_TOUCH_TO_RENDER].add(probeRender - probeTouch);
+  hist[LAT_RENDER_TO_OUTPUT].add(now - probeRender);
+  hist[LAT_TOUCH_TO_OUTPUT].add(now - probeTouch);
+  state = PROBE_IDLE;
+}
+
+void LatencyProbe::print(void (*emit)(const char *line),
+                         const char *outputNote) {
+  static const char *names[LAT_SEGMENT_COUNT] = {"touch->render",
+                                                 "render->output",
+                                                 "touch->output"};
+  char line[96];
+  snprintf(line, sizeof(line), "%-15s %6s %6s %6s %6s %6s %6s", "latency ms",
+           "n", "min", "p50", "p95", "p99", "max");
+  emit(line);
+
+  for (int s = 0; s < LAT_SEGMENT_COUNT; s++) {
+    const LatencyHistogram &h = hist[s];
+    if (h.count == 0) {
+      snprintf(line, sizeof(line), "%-15s %6u", names[s], 0u);
+    } else {
+      snprintf(line, sizeof(line),
+               "%-15s %6u %6.1f %6.1f %6.1f %6.1f %6.1f", names[s],
+               (unsigned)h.count, h.minUs / 1000.0f,
+               h.percentile(50) / 1000.0f, h.percentile(95) / 1000.0f,
+               h.percentile(99) / 1000.0f, h.maxUs / 1000.0f);
+    }
+    emit(line);
+  }
+  if (outputNote)
+    emit(outputNote);
+}
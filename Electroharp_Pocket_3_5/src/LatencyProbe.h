@@ -0,0 +1,78 @@
+#ifndef LATENCY_PROBE_H
+#define LATENCY_PROBE_H
+
+#include "Platform.h"
+
+// --- TOUCH-TO-SOUND LATENCY PROBE ---
+// Follows one strum at a time through the pipeline:
+//   touch   : ts.getPoint() that led to triggerNote() (UI core)
+//   render  : end of the render block in which the voice first sounded
+//   output  : that audio handed to I2S DMA (write returned) / read from the
+//             BT feed ring by the A2DP callback
+// Device buffering after the hand-off (remaining DMA queue, A2DP stack)
+// is not measurable here and is reported as a note only.
+#define LATENCY_BIN_US 500 // Histogram resolution
+#define LATENCY_BINS 256   // 0 - 128ms (last bin collects overflow)
+
+struct LatencyHistogram {
+  uint32_t count;
+  uint32_t minUs;
+  uint32_t maxUs;
+  uint32_t bins[LATENCY_BINS];
+
+  void clear();
+  void add(uint32_t us);
+  uint32_t percentile(int pct) const; // Upper bin edge (us)
+};
+
+enum LatencySegment : uint8_t {
+  LAT_TOUCH_TO_RENDER,
+  LAT_RENDER_TO_OUTPUT,
+  LAT_TOUCH_TO_OUTPUT,
+  LAT_SEGMENT_COUNT
+};
+
+class LatencyProbe {
+public:
+  LatencyProbe();
+
+  // UI core: stamp the touch, consumed by the next note-on that is posted
+  void touch(uint32_t us) { touchUs = us; }
+  uint32_t takeTouch() {
+    uint32_t t = touchUs;
+    touchUs = 0;
+    return t;
+  }
+
+  // Audio side
+  void noteStarted(uint32_t touchTime);
+  void blockRendered();
+  // Buffered output: position (items written) that contains the block
+  void setOutputMark(uint32_t written);
+  void handedOff();
+  // Buffered output: count only once the consumer has passed the mark
+  void handedOff(uint32_t consumed);
+
+  // UI core
+  void requestReset() { resetPending = true; }
+  const LatencyHistogram &segment(LatencySegment s) const { return hist[s]; }
+  void print(void (*emit)(const char *line), const char *outputNote);
+
+private:
+  enum State : uint8_t { PROBE_IDLE, PROBE_STARTED, PROBE_RENDERED };
+
+  uint32_t touchUs = 0;
+
+  volatile State state = PROBE_IDLE;
+  uint32_t probeTouch = 0;
+  uint32_t probeRender = 0;
+  uint32_t outputMark = 0;
+  volatile bool markSet = false;
+
+  LatencyHistogram hist[LAT_SEGMENT_COUNT];
+  volatile bool resetPending = false; // Applied on the audio side
+};
+
+extern LatencyProbe latencyProbe;
+
+#endif
@@ -0,0 +1,109 @@
+#include "Modulation.h"
+#include "AudioEngine.h"
+#include "SynthVoice.h"
+
+// Phase in cycles (0..1) -> sin(2*PI*phase), linear interpolation
+float IRAM_ATTR ModulationEngine::sineAt(float phase) {
+  float pos = phase * 256.0f;
+  int idx = (int)pos;
+  float frac = pos - (float)idx;
+  idx &= 255;
+  float s1 = SynthVoice::sineLUT[idx];
+  float s2 = SynthVoice::sineLUT[(idx + 1) & 255];
+  return s1 + (s2 - s1) * frac;
+}
+
+// LFO value at the current control point (-1.0 to 1.0)
+float IRAM_ATTR ModulationEngine::lfoValue(const ParamSnapshot &p) {
+  switch (p.lfoType) {
+  case LFO_SINE:
+    return sineAt(lfoPhase);
+  case LFO_SQUARE:
+    return (lfoPhase < 0.5f) ? 1.0f : -1.0f;
+  case LFO_RAMP:
+    return (lfoPhase * 2.0f) - 1.0f;
+  case LFO_NOISE:
+    // xorshift32: cheap stand-in for random() on the audio core
+    noiseSeed ^= noiseSeed << 13;
+    noiseSeed ^= noiseSeed >> 17;
+    noiseSeed ^= noiseSeed << 5;
+    return (float)(noiseSeed >> 8) * (2.0f / 16777216.0f) - 1.0f;
+  }
+  return 0.0f;
+}
+
+static inline float wrapPhase(float ph) {
+  while (ph >= 1.0f)
+    ph -= 1.0f;
+  return ph;
+}
+
+void IRAM_ATTR ModulationEngine::process(const ParamSnapshot &p,
+                                         ModBuffers &out, int n) {
+  float fn = (float)n;
+
+  // 1. Advance Sources to the end of this block
+  lfoPhase = wrapPhase(lfoPhase + p.lfoInc * fn);
+  wowPhase = wrapPhase(wowPhase + p.wowInc * fn);
+  flutterPhase = wrapPhase(flutterPhase + p.flutterInc * fn);
+
+  float lfoVal = lfoValue(p);
+  float wobble = (sineAt(wowPhase) + sineAt(flutterPhase)) *
+                 0.0007f; // significantly reduced wobble
+
+  // 2. Control Point Targets (Apply LFO Targets)
+  float pitchMod = 1.0f + wobble;
+  float pwMod = 0.0f;
+  float resMod = 1.0f;
+  float cutoffMod = 0.0f;
+
+  if (p.fxLFO) {
+    float amt = lfoVal * p.lfoDepth;
+    if (p.lfoTarget == TARGET_PITCH) {
+      pitchMod += amt * 0.1f;
+    } else if (p.lfoTarget == TARGET_FOLD) {
+      pwMod += amt * 0.4f;
+    } else if (p.lfoTarget == TARGET_RES) {
+      resMod += amt * 0.5f;
+    } else if (p.lfoTarget == TARGET_FILTER) {
+      cutoffMod += amt * 1000.0f; // +/- 1kHz sweep
+    }
+  }
+
+  // Wave/Fold Parameter Mapping
+  float pw = (p.waveFold - 0.5f) + pwMod;
+
+  float trem = 1.0f;
+  if (p.fxTrem) {
+    tremPhase = wrapPhase(tremPhase + p.tremInc * fn);
+    trem = (1.0f + 0.5f * sineAt(tremPhase)) * 0.7f;
+  }
+
+  // 3. Linear Ramps from the previous control point
+  float dPitch = (pitchMod - lastPitch) / fn;
+  float dPw = (pw - lastPw) / fn;
+  float dTrem = (trem - lastTrem) / fn;
+  for (int i = 0; i < n; i++) {
+    float t = (float)(i + 1);
+    out.pitch[i] = lastPitch + dPitch * t;
+    out.pw[i] = lastPw + dPw * t;
+    out.trem[i] = lastTrem + dTrem * t;
+  }
+
+  // Cutoff only needs audio-rate values while it (or its ramp) is moving
+  out.cutoffActive = (cutoffMod != 0.0f || lastCutoff != 0.0f);
+  if (out.cutoffActive) {
+    float dCutoff = (cutoffMod - lastCutoff) / fn;
+    for (int i = 0; i < n; i++)
+      out.cutoff[i] = lastCutoff + dCutoff * (float)(i + 1);
+  }
+
+  // Resonance is applied per block: use the ramp midpoint
+  out.resMod = 0.5f * (lastRes + resMod);
+
+  lastPitch = pitchMod;
+  lastPw = pw;
+  lastTrem = trem;
+  lastRes = resMod;
+  lastCutoff = cutoffMod;
+}
@@ -0,0 +1,52 @@
+#ifndef MODULATION_H
+#define MODULATION_H
+
+#include "Config.h"
+#include "Platform.h"
+
+struct ParamSnapshot;
+
+// --- MODULATION OUTPUTS (One Render Block) ---
+// Audio-rate buffers are linear ramps between control points, so the
+// voices/FX see smooth curves without per-sample transcendentals.
+struct ModBuffers {
+  float pitch[AUDIO_BLOCK_SIZE]; // Pitch multiplier (1.0 = none)
+  float pw[AUDIO_BLOCK_SIZE];    // PW / Fold offset
+  float trem[AUDIO_BLOCK_SIZE];  // Tremolo gain (1.0 when off)
+  float cutoff[AUDIO_BLOCK_SIZE]; // Cutoff offset in Hz (LFO -> Filter)
+  bool cutoffActive;              // cutoff[] valid (else use fixed coeff)
+  float resMod;                   // Resonance factor (control rate)
+};
+
+// --- MODULATION ENGINE (Control Rate) ---
+// LFO, tape wobble (wow + flutter) and tremolo are evaluated once per block
+// from the shared sine table (SynthVoice::sineLUT). Phases are normalized
+// (0..1 cycles); increments come from the ParamSnapshot.
+class ModulationEngine {
+public:
+  // Advance all sources by n samples (n <= AUDIO_BLOCK_SIZE) and fill out
+  void IRAM_ATTR process(const ParamSnapshot &p, ModBuffers &out, int n);
+
+private:
+  static float sineAt(float phase); // Interpolated table lookup
+
+  float lfoValue(const ParamSnapshot &p);
+
+  // Source Phases
+  float lfoPhase = 0.0f;
+  float wowPhase = 0.0f;
+  float flutterPhase = 0.0f;
+  float tremPhase = 0.0f;
+
+  // Noise LFO (held per control point, ramped like the others)
+  uint32_t noiseSeed = 0x9E3779B9;
+
+  // Previous Control Point (ramp start)
+  float lastPitch = 1.0f;
+  float lastPw = 0.0f;
+  float lastTrem = 1.0f;
+  float lastRes = 1.0f;
+  float lastCutoff = 0.0f;
+};
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef PLATFORM_H
+#define PLATFORM_H
+
+// --- PLATFORM SHIM ---
+// The DSP core (Config, SynthVoice, Modulation, VoicePool, AudioEngine,
+// Upsampler) includes this instead of <Arduino.h> so the same sources also
+// build on a desktop (PlatformIO env:native, see src/native/RenderWav.cpp).
+// Only what the DSP core actually uses is provided off-target.
+#ifdef ARDUINO
+#include <Arduino.h>
+#else
+#include <chrono>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define IRAM_ATTR
+
+#ifndef PI
+#define PI 3.1415926535897932384626433832795
+#endif
+
+// Monotonic microseconds (wraps like the Arduino core)
+inline uint32_t micros() {
+  return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+#endif
+
+#endif
@@ -0,0 +1,97 @@
+#include "Profiler.h"
+
+#if DSP_PROFILER
+
+DspProfiler dspProfiler;
+
+static const char *stageNames[PROF_STAGE_COUNT] = {
+    "block", "events", "modulation", "voices", "svf",
+    "drive", "delay",  "tremolo",    "out_spk", "out_bt"};
+
+// Log histogram: PROF_SUB_BINS linear steps per power of two
+static inline int binFor(uint32_t c) {
+  if (c < PROF_SUB_BINS)
+    return (int)c;
+  int msb = 31 - __builtin_clz(c);
+  return (msb - 1) * PROF_SUB_BINS + (int)((c >> (msb - 2)) & 3);
+}
+
+// Largest value that lands in bin b
+static uint32_t binUpper(int b) {
+  if (b < PROF_SUB_BINS)
+    return (uint32_t)b;
+  int msb = b / PROF_SUB_BINS + 1;
+  uint32_t step = 1u << (msb - 2);
+  uint32_t lower = (uint32_t)(PROF_SUB_BINS + b % PROF_SUB_BINS) * step;
+  return lower + step - 1;
+}
+
+void DspProfiler::clear() {
+  memset(stages, 0, sizeof(stages));
+  for (int s = 0; s < PROF_STAGE_COUNT; s++)
+    stages[s].minCycles = 0xFFFFFFFF;
+}
+
+void IRAM_ATTR DspProfiler::record(ProfStage stage, uint32_t cycles) {
+  if (resetPending) {
+    clear();
+    resetPending = false;
+  }
+  StageStats &st = stages[stage];
+  st.count++;
+  st.totalCycles += cycles;
+  if (cycles < st.minCycles)
+    st.minCycles = cycles;
+  if (cycles > st.maxCycles)
+    st.maxCycles = cycles;
+  st.bins[binFor(cycles)]++;
+}
+
+void DspProfiler::print(ProfEmit emit) {
+  char line[96];
+  snprintf(line, sizeof(line), "%-10s %8s %8s %8s %8s %8s", "stage", "blocks",
+           "min", "avg", "p99", "max");
+  emit(line);
+
+  for (int s = 0; s < PROF_STAGE_COUNT; s++) {
+    // Snapshot (the audio core keeps recording while we print)
+    StageStats st = stages[s];
+    if (st.count == 0)
+      continue;
+
+    uint32_t target = st.count - st.count / 100; // 99th percentile rank
+    uint32_t seen = 0;
+    uint32_t p99 = st.maxCycles;
+    for (int b = 0; b < PROF_BINS; b++) {
+      seen += st.bins[b];
+      if (seen >= target) {
+        p99 = binUpper(b);
+        break;
+      }
+    }
+    if (p99 > st.maxCycles)
+      p99 = st.maxCycles;
+
+    snprintf(line, sizeof(line), "%-10s %8u %8u %8u %8u %8u", stageNames[s],
+             (unsigned)st.count, (unsigned)st.minCycles,
+             (unsigned)(st.totalCycles / st.count), (unsigned)p99,
+             (unsigned)st.maxCycles);
+    emit(line);
+  }
+  snprintf(line, sizeof(line),
+           "(cycles per %d-sample block, out_spk per DMA buffer)",
+           AUDIO_BLOCK_SIZE);
+  emit(line);
+}
+
+void profilerPrint(ProfEmit emit) { dspProfiler.print(emit); }
+void profilerReset() { dspProfiler.requestReset(); }
+
+#else
+
+void profilerPrint(ProfEmit emit) {
+  emit("Profiler disabled (build env:cyd_profile, DSP_PROFILER=1)");
+}
+void profilerReset() {}
+
+#endif
@@ -0,0 +1,112 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "Config.h"
+#include "Platform.h"
+
+// --- DSP STAGE PROFILER ---
+// Cycle counts (Xtensa CCOUNT; ns on a host build) per render stage,
+// accumulated over one render block and recorded into a log histogram.
+// Serial "stats" prints min / avg / p99 / max per stage, "stats reset"
+// clears them. Release builds compile every hook out (env:cyd_profile
+// sets DSP_PROFILER=1).
+#ifndef DSP_PROFILER
+#define DSP_PROFILER 0
+#endif
+
+enum ProfStage : uint8_t {
+  PROF_BLOCK,      // Whole renderBlock (incl. silence fast path)
+  PROF_EVENTS,     // Note events + parameter snapshot
+  PROF_MODULATION, // LFO / wobble / tremolo control rate
+  PROF_VOICES,     // Voice loop (oscillators + envelopes)
+  PROF_SVF,        // Filter (incl. LFO cutoff lookup)
+  PROF_DRIVE,      // Drive
+  PROF_DELAY,      // Delay read + write
+  PROF_TREM,       // Tremolo gain
+  PROF_OUT_SPK,    // AudioOutput::write conversion, per DMA buffer
+  PROF_OUT_BT,     // A2DP upsampler + frame conversion
+  PROF_STAGE_COUNT
+};
+
+typedef void (*ProfEmit)(const char *line);
+
+// Cycle counter (always compiled: the polyphony governor learns from it in
+// release builds too)
+static inline uint32_t IRAM_ATTR profCycles() {
+#ifdef ARDUINO
+  return ESP.getCycleCount();
+#else
+  return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+#endif
+}
+
+static inline uint32_t profCyclesPerSecond() {
+#ifdef ARDUINO
+  return getCpuFrequencyMhz() * 1000000u;
+#else
+  return 1000000000u;
+#endif
+}
+
+#if DSP_PROFILER
+
+#define PROF_SUB_BINS 4 // Histogram bins per octave (p99 within ~19%)
+#define PROF_BINS (32 * PROF_SUB_BINS)
+
+struct StageStats {
+  uint32_t count;
+  uint32_t minCycles;
+  uint32_t maxCycles;
+  uint64_t totalCycles;
+  uint32_t bins[PROF_BINS];
+};
+
+class DspProfiler {
+public:
+  DspProfiler() { clear(); }
+
+  // Audio core: one sample per stage per block
+  void IRAM_ATTR record(ProfStage stage, uint32_t cycles);
+
+  // UI core
+  void requestReset() { resetPending = true; }
+  void print(ProfEmit emit);
+
+private:
+  void clear();
+
+  StageStats stages[PROF_STAGE_COUNT];
+  volatile bool resetPending = false; // Applied by the recorder
+};
+
+extern DspProfiler dspProfiler;
+
+// Lap timer: PROF_LAP charges the cycles since the previous lap to acc
+#define PROF_DECLARE(t) uint32_t t = profCycles()
+#define PROF_ACC(acc) uint32_t acc = 0
+#define PROF_LAP(t, acc)                                                       \
+  do {                                                                         \
+    uint32_t _now = profCycles();                                              \
+    (acc) += _now - (t);                                                       \
+    (t) = _now;                                                                \
+  } while (0)
+#define PROF_SKIP(t) (t) = profCycles()
+#define PROF_RECORD(stage, cycles) dspProfiler.record(stage, cycles)
+
+#else
+
+#define PROF_DECLARE(t)
+#define PROF_ACC(acc)
+#define PROF_LAP(t, acc)
+#define PROF_SKIP(t)
+#define PROF_RECORD(stage, cycles)
+
+#endif
+
+// UI side entry points (print a "disabled" note in release builds)
+void profilerPrint(ProfEmit emit);
+void profilerReset();
+
+#endif
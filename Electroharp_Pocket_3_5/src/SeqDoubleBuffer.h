@@ -0,0 +1,50 @@
+#ifndef SEQ_DOUBLE_BUFFER_H
+#define SEQ_DOUBLE_BUFFER_H
+
+#include <atomic>
+#include <stdint.h>
+
+// --- SEQUENCE-COUNTED DOUBLE BUFFER ---
+// One writer publishes whole values, one reader picks up the latest.
+// The writer fills the back slot and bumps the sequence; the reader copies
+// the front slot and re-checks the sequence. Neither side ever blocks:
+// a copy torn by a concurrent publish is discarded and the reader keeps its
+// previous value until the next call.
+template <typename T> class SeqDoubleBuffer {
+public:
+  // Writer side
+  void publish(const T &value) {
+    uint32_t s = seq.load(std::memory_order_relaxed);
+    // The back slot is the one a reader of seq s-1 may still be copying:
+    // keep the last bump ordered before the overwrite (pairs with the
+    // reader's acquire fence)
+    std::atomic_thread_fence(std::memory_order_release);
+    slots[(s + 1) & 1] = value;
+    seq.store(s + 1, std::memory_order_release);
+  }
+
+  // Reader side. Copies into out only if a newer, untorn value exists.
+  // lastSeq tracks what the reader has already seen.
+  bool read(T &out, uint32_t &lastSeq) {
+    uint32_t s = seq.load(std::memory_order_acquire);
+    if (s == lastSeq)
+      return false;
+
+    T tmp = slots[s & 1];
+
+    // Writer may have started on our slot (second publish since s)
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (seq.load(std::memory_order_relaxed) != s)
+      return false;
+
+    out = tmp;
+    lastSeq = s;
+    return true;
+  }
+
+private:
+  T slots[2];
+  std::atomic<uint32_t> seq{0};
+};
+
+#endif
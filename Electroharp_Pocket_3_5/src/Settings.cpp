@@ -34,6 +34,9 @@ Settings::Settings() {
   touch.isCalibrated = false; // Default
   defaultAudioMode = 0;
   audioProfileIndex = 0;
+  lowLatency = false;
+  headroom = GOVERNOR_HEADROOM;
+  splitRender = false;
 }
 
 void Settings::begin() {
@@ -52,6 +55,9 @@ void Settings::load() {
 
   defaultAudioMode = prefs.getInt("audioMode", 0);
   audioProfileIndex = prefs.getInt("audioProf", 0);
+  lowLatency = prefs.getBool("lowLat", false);
+  headroom = prefs.getInt("headroom", GOVERNOR_HEADROOM);
+  splitRender = prefs.getBool("split", false);
 
   Serial.println("Settings Loaded from NVS");
   Serial.printf("Touch: X(%d-%d) Y(%d-%d) Swap:%d\n", touch.minX, touch.maxX,
@@ -68,6 +74,9 @@ void Settings::save() {
   prefs.putBool("isCal", touch.isCalibrated);
   prefs.putInt("audioMode", defaultAudioMode);
   prefs.putInt("audioProf", audioProfileIndex);
+  prefs.putBool("lowLat", lowLatency);
+  prefs.putInt("headroom", headroom);
+  prefs.putBool("split", splitRender);
   Serial.println("Settings Saved to NVS");
 }
 
@@ -101,6 +110,9 @@ void Settings::reset() {
   touch.swapXY = true;
   touch.isCalibrated = false;
   defaultAudioMode = 0;
+  lowLatency = false;
+  headroom = GOVERNOR_HEADROOM;
+  splitRender = false;
   save(); // Write defaults back
   Serial.println("Settings Reset to Defaults");
 }
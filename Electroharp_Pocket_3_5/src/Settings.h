@@ -28,6 +28,9 @@ public:
   CalibrationData touch;
   int defaultAudioMode;  // 0=BootMenu, 1=Speaker, 2=BT
   int audioProfileIndex; // 0=Default, 1+ = Custom Pin Combos
+  bool lowLatency;       // Speaker: small DMA ring (grows on underrun)
+  int headroom;          // Governor: % of the render budget kept free
+  bool splitRender;      // Render half the voices on core 1
 
 private:
   Preferences prefs;
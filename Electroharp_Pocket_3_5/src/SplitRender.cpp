@@ -0,0 +1,146 @@
+#include "SplitRender.h"
+
+SplitRender splitRender;
+
+#ifdef ARDUINO
+
+bool SplitRender::begin(int core) {
+  if (worker != NULL)
+    return true;
+  if (doneSem == NULL)
+    doneSem = xSemaphoreCreateBinary();
+  if (doneSem == NULL)
+    return false;
+  TaskHandle_t handle = NULL;
+  BaseType_t ok = xTaskCreatePinnedToCore(workerEntry, "VoiceSplit", 4096,
+                                          this, SPLIT_WORKER_PRIORITY,
+                                          &handle, core);
+  if (ok != pdPASS)
+    return false;
+  worker = handle;
+  return true;
+}
+
+void SplitRender::workerEntry(void *arg) {
+  static_cast<SplitRender *>(arg)->work();
+}
+
+// Worker (core 1): one job per notification
+void IRAM_ATTR SplitRender::work() {
+  while (true) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    uint8_t expect = JOB_PENDING;
+    if (!claim.compare_exchange_strong(expect, JOB_TAKEN,
+                                       std::memory_order_acq_rel))
+      continue; // Reclaimed by the audio core (woke too late)
+    startUs = micros();
+
+    memset(jobMix, 0, jobN * sizeof(float));
+    for (int i = 0; i < jobCount; i++)
+      jobVoices[jobList[i]].renderBlock(jobMix, jobN, jobMod);
+
+    done.store(true, std::memory_order_release);
+    xSemaphoreGive((SemaphoreHandle_t)doneSem);
+  }
+}
+
+#else
+
+// Host: no second core, kick() always declines
+bool SplitRender::begin(int core) {
+  (void)core;
+  return false;
+}
+void SplitRender::workerEntry(void *arg) { (void)arg; }
+void SplitRender::work() {}
+
+#endif
+
+// Audio core: split the voices, the worker takes the newer half.
+// Returns how many (from the front of list) the caller renders itself.
+int IRAM_ATTR SplitRender::kick(SynthVoice *voices, const int *list,
+                                int count, int n, const ModBlock &mod) {
+  if (!enabled || worker == NULL || count < SPLIT_MIN_VOICES)
+    return count;
+  if (backingOff) {
+    // Core 1 was busy: single-core for a while (wall clock, so it ends
+    // even while blocks are too small to split)
+    if (micros() - backoffStart < SPLIT_BACKOFF_US)
+      return count;
+    backingOff = false;
+  }
+
+  int local = count / 2;
+  jobVoices = voices;
+  jobCount = count - local;
+  memcpy(jobList, list + local, jobCount * sizeof(int));
+  jobN = n;
+  jobMod = mod;
+
+  done.store(false, std::memory_order_release);
+  claim.store(JOB_PENDING, std::memory_order_release);
+  kickUs = micros();
+#ifdef ARDUINO
+  xTaskNotifyGive((TaskHandle_t)worker);
+#endif
+  return local;
+}
+
+// Audio core: barrier, then mix in the worker's voices
+bool IRAM_ATTR SplitRender::join(float *accum, int n) {
+#ifdef ARDUINO
+  // The done flag decides: a give left over from a job that finished
+  // before the last join looked is simply taken again. Past one block
+  // period an unclaimed job comes back; a claimed one is already running.
+  uint32_t deadlineUs = (uint32_t)n * 1000000u / SAMPLE_RATE;
+  while (!done.load(std::memory_order_acquire)) {
+    if (micros() - kickUs > deadlineUs) {
+      uint8_t expect = JOB_PENDING;
+      if (claim.compare_exchange_strong(expect, JOB_RECLAIMED,
+                                        std::memory_order_acq_rel)) {
+        for (int i = 0; i < jobCount; i++)
+          jobVoices[jobList[i]].renderBlock(accum, n, jobMod);
+        reclaims++;
+        countStart(true);
+        return false;
+      }
+    }
+    xSemaphoreTake((SemaphoreHandle_t)doneSem, 1);
+  }
+#endif
+  for (int i = 0; i < n; i++)
+    accum[i] += jobMix[i];
+
+  // Wake latency decides whether core 1 is worth waiting for
+  uint32_t lat = startUs - kickUs;
+  if (lat > maxStartUs)
+    maxStartUs = lat;
+  splitBlocks++;
+  countStart(lat > SPLIT_LATE_US);
+  return true;
+}
+
+void IRAM_ATTR SplitRender::countStart(bool late) {
+  if (late) {
+    lateStarts++;
+    if (++lateStreak >= SPLIT_LATE_STREAK) {
+      lateStreak = 0;
+      backingOff = true;
+      backoffStart = micros();
+      backoffs++;
+    }
+  } else {
+    lateStreak = 0;
+  }
+}
+
+void SplitRender::print(void (*emit)(const char *line)) {
+  char line[160];
+  snprintf(line, sizeof(line),
+           "split: %s%s | blocks %u | late %u | reclaimed %u | backoffs %u "
+           "| worst start %u us",
+           enabled ? "on" : "off", isAvailable() ? "" : " (no worker)",
+           (unsigned)splitBlocks, (unsigned)lateStarts, (unsigned)reclaims,
+           (unsigned)backoffs, (unsigned)maxStartUs);
+  emit(line);
+}
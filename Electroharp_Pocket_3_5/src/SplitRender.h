@@ -0,0 +1,90 @@
+#ifndef SPLIT_RENDER_H
+#define SPLIT_RENDER_H
+
+#include "Config.h"
+#include "Platform.h"
+#include "SynthVoice.h"
+#include <atomic>
+
+// --- DUAL-CORE SPLIT RENDER ---
+// Optional: a worker task on core 1 renders part of the voices into its own
+// block buffer while the audio core renders the rest; the audio core then
+// sums both and runs the shared SVF + FX. One barrier per block:
+//   audio core: kick() -> notify worker -> own voices -> join() (wait)
+//   worker    : wake -> render its voices -> done flag + give doneSem
+// The audio task's own notification slot is left alone (A2DP refills and
+// preset changes use it); the worker reports on a dedicated semaphore.
+// The pool is only touched by the audio core, before kick() / after join().
+// join() waits at most one block period for the worker to pick the job up;
+// a job still unclaimed then is taken back (atomic claim) and rendered on
+// the audio core, so a starved core 1 never stalls the DMA.
+// Degrades to single-core: if the worker starts late (UI / SPI busy on
+// core 1) for SPLIT_LATE_STREAK blocks in a row, split is held off for
+// SPLIT_BACKOFF_US. Host builds are always single-core.
+#define SPLIT_MIN_VOICES 6       // Fewer: the barrier costs more than it saves
+#define SPLIT_LATE_US 250        // Worker start later than this = late
+#define SPLIT_LATE_STREAK 3      // Late blocks in a row before backing off
+#define SPLIT_BACKOFF_US 1000000 // Single-core hold after a late streak
+#define SPLIT_WORKER_PRIORITY 18 // Above the UI loop, below the audio task
+
+class SplitRender {
+public:
+  // Device: start the worker task on `core`. Host: no worker.
+  bool begin(int core);
+  bool isAvailable() const { return worker != NULL; }
+
+  // UI core: turn split mode on/off (takes effect at the next block)
+  void setEnabled(bool on) { enabled = on; }
+  bool isEnabled() const { return enabled; }
+
+  // Audio core: hand the newer part of voices[list[0..count)] to the
+  // worker. Returns how many (from the front) the caller renders itself;
+  // count when split is off, backing off or there are too few voices.
+  int kick(SynthVoice *voices, const int *list, int count, int n,
+           const ModBlock &mod);
+  // Audio core: wait for the worker and add its mix into accum. Returns
+  // false if the job had to be reclaimed (rendered on the audio core).
+  bool join(float *accum, int n);
+
+  // Telemetry (audio core writes, UI reads)
+  uint32_t splitBlocks = 0; // Blocks rendered on both cores
+  uint32_t lateStarts = 0;  // Worker woke later than SPLIT_LATE_US
+  uint32_t backoffs = 0;    // Fell back to single-core
+  uint32_t maxStartUs = 0;  // Worst worker wake latency
+  uint32_t reclaims = 0;    // Jobs taken back from a worker that never woke
+
+  void print(void (*emit)(const char *line));
+
+private:
+  static void workerEntry(void *arg);
+  void work();
+  void countStart(bool late);
+
+  // Job ownership: the first of worker / audio core to move it off PENDING
+  enum : uint8_t { JOB_PENDING, JOB_TAKEN, JOB_RECLAIMED };
+
+  void *worker = NULL;  // TaskHandle_t (opaque for host builds)
+  void *doneSem = NULL; // SemaphoreHandle_t, given when the job is done
+  volatile bool enabled = false;
+
+  // Job (written by the audio core before the kick)
+  SynthVoice *jobVoices = NULL;
+  int jobList[MAX_VOICES];
+  int jobCount = 0;
+  int jobN = 0;
+  ModBlock jobMod = {NULL, NULL};
+  float jobMix[AUDIO_BLOCK_SIZE];
+
+  uint32_t kickUs = 0;
+  volatile uint32_t startUs = 0;
+  std::atomic<bool> done{true};
+  std::atomic<uint8_t> claim{JOB_TAKEN};
+
+  int lateStreak = 0;
+  bool backingOff = false;
+  uint32_t backoffStart = 0;
+};
+
+extern SplitRender splitRender;
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <stdint.h>
+
+// --- LOCK-FREE SPSC QUEUE ---
+// Single producer (one task/core) -> single consumer (another task/core).
+// N must be a power of two; indices run free and are masked on access.
+// No locks, no ISR masking: push/pop are wait-free.
+template <typename T, uint32_t N> class SpscQueue {
+  static_assert(N > 0 && (N & (N - 1)) == 0, "N must be a power of two");
+
+public:
+  // Producer side. Returns false (item dropped) if full.
+  bool push(const T &item) {
+    uint32_t h = head.load(std::memory_order_relaxed);
+    if (h - tail.load(std::memory_order_acquire) >= N)
+      return false;
+    buf[h & (N - 1)] = item;
+    head.store(h + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side. Returns false if empty.
+  bool pop(T &item) {
+    uint32_t t = tail.load(std::memory_order_relaxed);
+    if (t == head.load(std::memory_order_acquire))
+      return false;
+    item = buf[t & (N - 1)];
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Approximate fill level (exact when called from either end)
+  uint32_t size() const {
+    return head.load(std::memory_order_acquire) -
+           tail.load(std::memory_order_acquire);
+  }
+
+  static constexpr uint32_t capacity() { return N; }
+
+private:
+  T buf[N];
+  std::atomic<uint32_t> head{0}; // Written by producer only
+  std::atomic<uint32_t> tail{0}; // Written by consumer only
+};
+
+#endif
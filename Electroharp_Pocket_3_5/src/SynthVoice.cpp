@@ -15,6 +15,7 @@ void SynthVoice::trigger(float freq, int noteIdx, Waveform wave, float pw,
 
   active = true;
   held = true;
+  shedding = false;
   noteIndex = noteIdx;
   frequency = freq;
   phase = 0.0f;
@@ -45,6 +46,16 @@ void SynthVoice::trigger(float freq, int noteIdx, Waveform wave, float pw,
   phaseIncrement = freq / fs;
 }
 
+void SynthVoice::softTrigger(float freq, int noteIdx, Waveform wave,
+                             float pw, float attack, float decay,
+                             float sustain, float release) {
+  float keepPhase = phase;
+  float keepLevel = envelope;
+  trigger(freq, noteIdx, wave, pw, attack, decay, sustain, release);
+  phase = keepPhase;
+  envelope = keepLevel;
+}
+
 void SynthVoice::release() {
   if (!active)
     return;
@@ -52,22 +63,24 @@ void SynthVoice::release() {
   envState = ENV_RELEASE;
 }
 
-// Generate one sample
-float IRAM_ATTR SynthVoice::getSample(float pitchMod, float pwMod) {
+void SynthVoice::fastRelease(float seconds) {
   if (!active)
-    return 0;
-
-  float currentInc = phaseIncrement * pitchMod;
-
-  phase += currentInc;
-  if (phase >= 1.0f)
-    phase -= 1.0f;
-
-  float sample = 0.0f;
+    return;
+  float fs = (activeSampleRate > 0) ? (float)activeSampleRate : 22050.0f;
+  float level = (envelope > 0.001f) ? envelope : 0.001f;
+  releaseRate = level / (seconds * fs); // Reaches 0 in `seconds`
+  held = false;
+  shedding = true;
+  envState = ENV_RELEASE;
+}
 
+// --- Oscillator (Waveform dispatch hoisted out of the sample loop) ---
+void IRAM_ATTR SynthVoice::renderOscillator(float *out, int n,
+                                            const ModBlock &mod) {
   // Anti-Aliasing Strategy: Force Sine for Sparkle (High Pitch)
   // Soft Blend for high frequency: Smooth Saw/Square -> Triangle at > 2.5kHz
-  Waveform effWave = isSparkle ? WAVE_SINE : waveform;
+  // (Depends only on the note, so it is resolved once per block)
+  Waveform effWave = renderWave();
   float freq = phaseIncrement * (float)activeSampleRate;
   float blend = 0.0f;
   if (!isSparkle && (effWave == WAVE_SAW || effWave == WAVE_SQUARE)) {
@@ -77,83 +90,142 @@ float IRAM_ATTR SynthVoice::getSample(float pitchMod, float pwMod) {
         blend = 1.0f;
     }
   }
-
-  if (effWave == WAVE_SAW) {
-    float raw = (phase * 2.0f) - 1.0f;
-    if (pwMod > 0.01f) {
-      float gain = 1.0f + (pwMod * 3.0f);
-      raw *= gain;
-      if (raw > 1.0f)
-        raw = 2.0f - raw;
-      if (raw < -1.0f)
-        raw = -2.0f - raw;
-      if (raw > 1.0f)
-        raw = 2.0f - raw;
-      if (raw < -1.0f)
-        raw = -2.0f - raw;
+  bool useBlend = blend > 0.01f;
+
+  float ph = phase;
+  float inc = phaseIncrement;
+
+  switch (effWave) {
+  case WAVE_SAW:
+    for (int i = 0; i < n; i++) {
+      ph += inc * mod.pitchMod[i];
+      if (ph >= 1.0f)
+        ph -= 1.0f;
+
+      float raw = (ph * 2.0f) - 1.0f;
+      float pwMod = mod.pwMod[i];
+      if (pwMod > 0.01f) {
+        float gain = 1.0f + (pwMod * 3.0f);
+        raw *= gain;
+        if (raw > 1.0f)
+          raw = 2.0f - raw;
+        if (raw < -1.0f)
+          raw = -2.0f - raw;
+        if (raw > 1.0f)
+          raw = 2.0f - raw;
+        if (raw < -1.0f)
+          raw = -2.0f - raw;
+      }
+      if (useBlend) {
+        float t = (ph * 2.0f) - 1.0f;
+        float tri = 2.0f * fabs(t) - 1.0f;
+        raw = raw * (1.0f - blend) + tri * blend;
+      }
+      out[i] = raw;
     }
-    sample = raw;
+    break;
 
-    if (blend > 0.01f) {
-      float t = (phase * 2.0f) - 1.0f;
-      float tri = 2.0f * fabs(t) - 1.0f;
-      sample = sample * (1.0f - blend) + tri * blend;
-    }
-  } else if (effWave == WAVE_SQUARE) {
-    float pw = 0.5f + pwMod;
-    if (pw < 0.05f)
-      pw = 0.05f;
-    if (pw > 0.95f)
-      pw = 0.95f;
-    float raw = (phase < pw) ? 1.0f : -1.0f;
-    float dcOffset = 2.0f * pw - 1.0f;
-    sample = raw - dcOffset;
-
-    if (blend > 0.01f) {
-      float t = (phase * 2.0f) - 1.0f;
-      float tri = 2.0f * fabs(t) - 1.0f;
-      sample = sample * (1.0f - blend) + tri * blend;
+  case WAVE_SQUARE:
+    for (int i = 0; i < n; i++) {
+      ph += inc * mod.pitchMod[i];
+      if (ph >= 1.0f)
+        ph -= 1.0f;
+
+      float pw = 0.5f + mod.pwMod[i];
+      if (pw < 0.05f)
+        pw = 0.05f;
+      if (pw > 0.95f)
+        pw = 0.95f;
+      float raw = (ph < pw) ? 1.0f : -1.0f;
+      float dcOffset = 2.0f * pw - 1.0f;
+      float sample = raw - dcOffset;
+
+      if (useBlend) {
+        float t = (ph * 2.0f) - 1.0f;
+        float tri = 2.0f * fabs(t) - 1.0f;
+        sample = sample * (1.0f - blend) + tri * blend;
+      }
+      out[i] = sample;
     }
-  } else if (effWave == WAVE_SINE) {
+    break;
+
+  case WAVE_SINE:
     // High quality sine via LUT with Linear Interpolation
     // Phase 0..1 maps to 0..256
-    float p = phase * 256.0f;
-    int idx = (int)p;
-    float frac = p - idx;
-
-    // Wrap index safely
-    int idx2 = (idx + 1) & 0xFF; // 256 wrap
-    idx &= 0xFF;
-
-    float s1 = sineLUT[idx];
-    float s2 = sineLUT[idx2];
-
-    sample = s1 + (s2 - s1) * frac;
-  } else if (effWave == WAVE_TRIANGLE) {
-    // Triangle with Wavefolding
-    float t = (phase * 2.0f) - 1.0f;
-    float tri = 2.0f * fabs(t) - 1.0f;
+    for (int i = 0; i < n; i++) {
+      ph += inc * mod.pitchMod[i];
+      if (ph >= 1.0f)
+        ph -= 1.0f;
+
+      float p = ph * 256.0f;
+      int idx = (int)p;
+      float frac = p - idx;
+
+      // Wrap index safely
+      int idx2 = (idx + 1) & 0xFF; // 256 wrap
+      idx &= 0xFF;
+
+      float s1 = sineLUT[idx];
+      float s2 = sineLUT[idx2];
+      out[i] = s1 + (s2 - s1) * frac;
+    }
+    break;
 
+  case WAVE_TRIANGLE: {
+    // Triangle with Wavefolding (Fold gain is per-voice, not per-sample)
     float gain = 1.0f + (pulseWidth * 5.0f);
-    tri *= gain;
-
-    // Safer Fold
-    if (tri > 1.0f)
-      tri = 2.0f - tri;
-    if (tri < -1.0f)
-      tri = -2.0f - tri;
-    if (tri > 1.0f)
-      tri = 2.0f - tri;
-    if (tri < -1.0f)
-      tri = -2.0f - tri;
-
-    sample = tri;
+    for (int i = 0; i < n; i++) {
+      ph += inc * mod.pitchMod[i];
+      if (ph >= 1.0f)
+        ph -= 1.0f;
+
+      float t = (ph * 2.0f) - 1.0f;
+      float tri = (2.0f * fabs(t) - 1.0f) * gain;
+
+      // Safer Fold
+      if (tri > 1.0f)
+        tri = 2.0f - tri;
+      if (tri < -1.0f)
+        tri = -2.0f - tri;
+      if (tri > 1.0f)
+        tri = 2.0f - tri;
+      if (tri < -1.0f)
+        tri = -2.0f - tri;
+      out[i] = tri;
+    }
+  } break;
   }
 
-  // Apply Gain
-  sample *= mixGain;
+  phase = ph;
+}
 
-  // 2. Apply Envelope
+// --- Envelope Segments ---
+// Number of samples the current segment can run as a plain linear ramp
+// without crossing its end point. 0 means the next sample is a boundary.
+int SynthVoice::samplesToBoundary() {
+  int run = 0;
+  switch (envState) {
+  case ENV_ATTACK:
+    run = (int)((1.0f - envelope) / attackRate) - 1;
+    break;
+  case ENV_DECAY:
+    run = (int)((envelope - sustainLvl) / decayRate) - 1;
+    break;
+  case ENV_SUSTAIN:
+    run = held ? AUDIO_BLOCK_SIZE : 0;
+    break;
+  case ENV_RELEASE:
+    run = (int)(envelope / releaseRate) - 1;
+    break;
+  case ENV_IDLE:
+    run = 0;
+    break;
+  }
+  return (run > 0) ? run : 0;
+}
+
+// Exact single-sample envelope update (handles segment transitions)
+void SynthVoice::stepEnvelope() {
   switch (envState) {
   case ENV_ATTACK:
     envelope += attackRate;
@@ -192,8 +264,55 @@ float IRAM_ATTR SynthVoice::getSample(float pitchMod, float pwMod) {
     active = false;
     break;
   }
+}
+
+// Render a block and accumulate into the mix buffer
+void IRAM_ATTR SynthVoice::renderBlock(float *accum, int n,
+                                       const ModBlock &mod) {
+  if (!active)
+    return;
+  if (n > AUDIO_BLOCK_SIZE)
+    n = AUDIO_BLOCK_SIZE;
+
+  // 1. Oscillator
+  float osc[AUDIO_BLOCK_SIZE];
+  renderOscillator(osc, n, mod);
+
+  // 2. Apply Gain + Envelope (blocks split only at segment boundaries)
+  float g = mixGain;
+  int i = 0;
+  while (i < n) {
+    int run = samplesToBoundary();
+    if (run > n - i)
+      run = n - i;
+
+    if (run > 0) {
+      float rate = 0.0f;
+      if (envState == ENV_ATTACK)
+        rate = attackRate;
+      else if (envState == ENV_DECAY)
+        rate = -decayRate;
+      else if (envState == ENV_RELEASE)
+        rate = -releaseRate;
+
+      float env = envelope;
+      for (int k = i; k < i + run; k++) {
+        env += rate;
+        accum[k] += osc[k] * g * env;
+      }
+      envelope = env;
+      i += run;
+    }
 
-  return sample * envelope;
+    if (i < n) {
+      // Boundary sample: exact per-sample transition
+      stepEnvelope();
+      accum[i] += osc[i] * g * envelope;
+      i++;
+      if (!active)
+        break;
+    }
+  }
 }
 
 // --- Static Resources ---
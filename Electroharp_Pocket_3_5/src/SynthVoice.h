@@ -2,19 +2,26 @@
 #define SYNTH_VOICE_H
 
 #include "Config.h"
-#include <Arduino.h>
+#include "Platform.h"
 
 extern volatile int activeSampleRate;
 
 enum Waveform { WAVE_SAW, WAVE_SQUARE, WAVE_SINE, WAVE_TRIANGLE };
 enum EnvState { ENV_IDLE, ENV_ATTACK, ENV_DECAY, ENV_SUSTAIN, ENV_RELEASE };
 
+// Per-Sample Modulation for one render block (n values each)
+struct ModBlock {
+  const float *pitchMod; // Pitch multiplier (1.0 = none)
+  const float *pwMod;    // PW / Fold offset
+};
+
 class SynthVoice {
 public:
   bool active = false;
   bool held = false;
   bool isLatchedArp = false; // New flag
   bool isSparkle = false;    // New flag for Sparkle Mode
+  bool shedding = false;     // Fast release ordered by the governor
   int noteIndex = -1;
 
   float frequency;
@@ -42,6 +49,8 @@ public:
 
   // Setters
   void setWaveform(Waveform w) { waveform = w; }
+  // What renderBlock() actually plays (Sparkle is always a sine)
+  Waveform renderWave() const { return isSparkle ? WAVE_SINE : waveform; }
   void setPulseWidth(float pw) { pulseWidth = pw; }
   void setADSR(float a, float d, float s, float r) {
     attackTime = a;
@@ -62,14 +71,32 @@ public:
   void trigger(float freq, int noteIdx, Waveform wave, float pw, float attack,
                float decay, float sustain, float release);
 
+  // Same-note retrigger: the oscillator keeps its phase and the attack
+  // resumes from the current level (no discontinuity)
+  void softTrigger(float freq, int noteIdx, Waveform wave, float pw,
+                   float attack, float decay, float sustain, float release);
+
   void release();
+  // Governor shedding: fade out from the current level in `seconds`
+  void fastRelease(float seconds);
+  // Stop at once (release tail already below the output resolution)
+  void retireNow() {
+    envelope = 0.0f;
+    envState = ENV_IDLE;
+    active = false;
+  }
 
-  // Generate one sample
-  float IRAM_ATTR getSample(float pitchMod, float pwMod);
+  // Render n samples (n <= AUDIO_BLOCK_SIZE) and ADD them into accum
+  void IRAM_ATTR renderBlock(float *accum, int n, const ModBlock &mod);
 
   // Static Resources
   static float sineLUT[256];
   static void initLUT();
+
+private:
+  void renderOscillator(float *out, int n, const ModBlock &mod);
+  int samplesToBoundary();
+  void stepEnvelope();
 };
 
 #endif
@@ -0,0 +1,36 @@
+#include "Upsampler.h"
+
+// Odd-phase taps at +/-0.5, 1.5 ... 5.5 input samples (Kaiser, beta 5)
+// Normalized so each pair sum adds to unity gain at DC.
+static const float halfBandCoeffs[UPSAMPLE_PAIRS] = {
+    0.630498435f, -0.188816941f, 0.090787062f,
+    -0.045563685f, 0.021062924f, -0.007967794f};
+
+void HalfBandUpsampler::reset() {
+  memset(hist, 0, sizeof(hist));
+  pos = 0;
+}
+
+void IRAM_ATTR HalfBandUpsampler::process(const float *in, float *out,
+                                          int n) {
+  for (int i = 0; i < n; i++) {
+    // Push newest sample into both halves of the ring
+    pos++;
+    if (pos >= UPSAMPLE_HIST)
+      pos = 0;
+    hist[pos] = in[i];
+    hist[pos + UPSAMPLE_HIST] = in[i];
+
+    // Window: w[0] = oldest ... w[11] = newest. Centre sits between w[5]/w[6]
+    const float *w = &hist[pos + 1];
+    const int c = UPSAMPLE_PAIRS - 1;
+
+    float interp = 0.0f;
+    for (int k = 0; k < UPSAMPLE_PAIRS; k++) {
+      interp += halfBandCoeffs[k] * (w[c - k] + w[c + 1 + k]);
+    }
+
+    out[i * 2] = w[c];
+    out[i * 2 + 1] = interp;
+  }
+}
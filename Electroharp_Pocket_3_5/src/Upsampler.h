@@ -0,0 +1,27 @@
+#ifndef UPSAMPLER_H
+#define UPSAMPLER_H
+
+#include "Platform.h"
+
+#define UPSAMPLE_PAIRS 6                  // Symmetric coefficient pairs
+#define UPSAMPLE_HIST (UPSAMPLE_PAIRS * 2) // Input history (12 taps)
+
+// --- 2x HALF-BAND UPSAMPLER (Polyphase) ---
+// Engine runs at SAMPLE_RATE, A2DP wants 44.1kHz. Even outputs are the
+// (delayed) input samples, odd outputs come from a 12-tap Kaiser windowed
+// sinc. Flat to ~8kHz, images of the 4.8kHz top note are down ~48dB.
+// Latency: 6 input samples (~0.27ms).
+class HalfBandUpsampler {
+public:
+  void reset();
+
+  // Upsample n input samples into 2 * n output samples
+  void IRAM_ATTR process(const float *in, float *out, int n);
+
+private:
+  // Doubled ring so the FIR window is always contiguous (no modulo per tap)
+  float hist[UPSAMPLE_HIST * 2] = {0};
+  int pos = 0;
+};
+
+#endif
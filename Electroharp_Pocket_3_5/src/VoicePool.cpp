@@ -0,0 +1,194 @@
+#include "VoicePool.h"
+
+VoicePool::VoicePool() {
+  for (int v = 0; v < MAX_VOICES; v++) {
+    activeNext[v] = activePrev[v] = VOICE_NONE;
+    heldNext[v] = heldPrev[v] = VOICE_NONE;
+    inHeld[v] = false;
+    heapPos[v] = -1;
+    silentAt[v] = 0;
+    // Pop order 0, 1, 2... (matches the old first-free scan)
+    freeStack[v] = MAX_VOICES - 1 - v;
+  }
+  freeCount = MAX_VOICES;
+  for (int n = 0; n < STRING_COUNT; n++)
+    noteVoice[n] = VOICE_NONE;
+}
+
+// --- Voice Allocation ---
+int VoicePool::allocate(int polyLimit) {
+  // 1. Free voice (if under the governor limit)
+  if (activeCount < polyLimit && freeCount > 0)
+    return freeStack[--freeCount];
+
+  // 2. Steal the released voice closest to silence
+  int v = (heapSize > 0) ? heap[0] : VOICE_NONE;
+
+  // 3. Steal the oldest held, unlatched voice
+  if (v == VOICE_NONE)
+    v = heldHead;
+
+  // 4. Desperation: everything is latched, steal the oldest
+  if (v == VOICE_NONE)
+    v = activeHead;
+
+  // Nothing active at all (polyLimit 0): fall back to any free voice
+  if (v == VOICE_NONE && freeCount > 0)
+    return freeStack[--freeCount];
+
+  if (v != VOICE_NONE) {
+    detach(v);
+    steals++;
+  }
+  return v;
+}
+
+void VoicePool::restart(int v) {
+  detach(v);
+  reuses++;
+}
+
+void VoicePool::start(int v) {
+  int note = voices[v].noteIndex;
+  if (note >= 0 && note < STRING_COUNT)
+    noteVoice[note] = (int8_t)v;
+
+  activePrev[v] = activeTail;
+  activeNext[v] = VOICE_NONE;
+  if (activeTail != VOICE_NONE)
+    activeNext[activeTail] = v;
+  else
+    activeHead = v;
+  activeTail = v;
+  activeCount++;
+
+  if (!voices[v].isLatchedArp) {
+    heldPrev[v] = heldTail;
+    heldNext[v] = VOICE_NONE;
+    if (heldTail != VOICE_NONE)
+      heldNext[heldTail] = v;
+    else
+      heldHead = v;
+    heldTail = v;
+    inHeld[v] = true;
+  }
+}
+
+void VoicePool::released(int v) {
+  unlinkHeld(v); // No-op for latched voices (never held)
+  if (heapPos[v] >= 0)
+    heapRemove(v); // Re-key (release rate changed)
+
+  // Linear release: silent after envelope / releaseRate samples
+  const SynthVoice &sv = voices[v];
+  uint32_t remain = 0;
+  if (sv.releaseRate > 0.0f)
+    remain = (uint32_t)(sv.envelope / sv.releaseRate);
+  silentAt[v] = clock + remain;
+  heapPush(v);
+}
+
+void VoicePool::retire(int v) {
+  detach(v);
+  freeStack[freeCount++] = v;
+}
+
+// --- List Maintenance ---
+void VoicePool::detach(int v) {
+  int note = voices[v].noteIndex;
+  if (note >= 0 && note < STRING_COUNT && noteVoice[note] == v)
+    noteVoice[note] = VOICE_NONE;
+  unlinkActive(v);
+  unlinkHeld(v);
+  if (heapPos[v] >= 0)
+    heapRemove(v);
+}
+
+void VoicePool::unlinkActive(int v) {
+  int p = activePrev[v];
+  int n = activeNext[v];
+  if (p != VOICE_NONE)
+    activeNext[p] = n;
+  else if (activeHead == v)
+    activeHead = n;
+  else
+    return; // Not linked
+  if (n != VOICE_NONE)
+    activePrev[n] = p;
+  else
+    activeTail = p;
+  activePrev[v] = activeNext[v] = VOICE_NONE;
+  activeCount--;
+}
+
+void VoicePool::unlinkHeld(int v) {
+  if (!inHeld[v])
+    return;
+  int p = heldPrev[v];
+  int n = heldNext[v];
+  if (p != VOICE_NONE)
+    heldNext[p] = n;
+  else
+    heldHead = n;
+  if (n != VOICE_NONE)
+    heldPrev[n] = p;
+  else
+    heldTail = p;
+  heldPrev[v] = heldNext[v] = VOICE_NONE;
+  inHeld[v] = false;
+}
+
+// --- Release Heap ---
+void VoicePool::heapPush(int v) {
+  int i = heapSize++;
+  heap[i] = v;
+  heapPos[v] = i;
+  siftUp(i);
+}
+
+void VoicePool::heapRemove(int v) {
+  int i = heapPos[v];
+  int last = --heapSize;
+  heapPos[v] = -1;
+  if (i == last)
+    return;
+  int moved = heap[last];
+  heap[i] = moved;
+  heapPos[moved] = i;
+  siftUp(i);
+  siftDown(heapPos[moved]);
+}
+
+void VoicePool::heapSwap(int i, int j) {
+  int a = heap[i];
+  heap[i] = heap[j];
+  heap[j] = a;
+  heapPos[heap[i]] = i;
+  heapPos[heap[j]] = j;
+}
+
+void VoicePool::siftUp(int i) {
+  while (i > 0) {
+    int parent = (i - 1) / 2;
+    if (!quieter(heap[i], heap[parent]))
+      break;
+    heapSwap(i, parent);
+    i = parent;
+  }
+}
+
+void VoicePool::siftDown(int i) {
+  while (true) {
+    int l = 2 * i + 1;
+    int r = l + 1;
+    int best = i;
+    if (l < heapSize && quieter(heap[l], heap[best]))
+      best = l;
+    if (r < heapSize && quieter(heap[r], heap[best]))
+      best = r;
+    if (best == i)
+      break;
+    heapSwap(i, best);
+    i = best;
+  }
+}
@@ -0,0 +1,107 @@
+#ifndef VOICE_POOL_H
+#define VOICE_POOL_H
+
+#include "Config.h"
+#include "Platform.h"
+#include "SynthVoice.h"
+
+#define VOICE_NONE -1
+
+enum VoiceRole : uint8_t { ROLE_STRUM, ROLE_LATCHED_ARP, ROLE_SPARKLE };
+
+// --- VOICE POOL ---
+// Owns the voices plus index structures so nothing scans all MAX_VOICES:
+//  - Active list: live voices, oldest trigger first (render order)
+//  - Held list: unlatched voices not yet released, oldest trigger first
+//  - Release heap: every voice in release (latched arp steps included),
+//    min-heap on the sample at which the linear release reaches silence
+//    (quietest / closest to done)
+//  - Free stack: idle voices
+//  - Note map: noteIndex -> newest voice on that string (same-note reuse)
+// One allocator for every role (strum, latched arp, sparkle). Steal order:
+// closest-to-silent released voice, then the oldest held unlatched voice,
+// then (everything latched) the oldest voice. O(1) picks, O(log n) heap
+// upkeep. Audio core only.
+class VoicePool {
+public:
+  VoicePool();
+
+  SynthVoice voices[MAX_VOICES];
+
+  // Pick a voice for a note-on (free if under polyLimit, else steal).
+  // The returned voice is detached; call start() after triggering it.
+  int allocate(int polyLimit);
+
+  // Newest live voice on a string, or VOICE_NONE
+  int findNote(int noteIdx) const {
+    return (noteIdx >= 0 && noteIdx < STRING_COUNT) ? noteVoice[noteIdx]
+                                                    : VOICE_NONE;
+  }
+  // Detach a live voice so it can be retriggered (same-note reuse)
+  void restart(int v);
+
+  // Link a freshly triggered voice as the newest active voice
+  void start(int v);
+  // Voice entered release (call after SynthVoice::release() or after its
+  // release rate changed; re-keys a voice that is already releasing)
+  void released(int v);
+  // Voice went idle (envelope finished)
+  void retire(int v);
+
+  // Sample clock for the release heap (once per render block)
+  void advance(int n) { clock += (uint32_t)n; }
+
+  // Iteration over live voices (oldest first). Cache next() before
+  // retiring the current voice.
+  int first() const { return activeHead; }
+  int next(int v) const { return activeNext[v]; }
+  int count() const { return activeCount; }
+
+  uint32_t steals = 0; // Voices taken from a sounding note
+  uint32_t reuses = 0; // Note-ons that retriggered their string's voice
+
+private:
+  void detach(int v);
+  void unlinkActive(int v);
+  void unlinkHeld(int v);
+
+  // Release Heap
+  bool quieter(int a, int b) const {
+    return (int32_t)(silentAt[a] - silentAt[b]) < 0;
+  }
+  void heapPush(int v);
+  void heapRemove(int v);
+  void heapSwap(int i, int j);
+  void siftUp(int i);
+  void siftDown(int i);
+
+  // Active List (doubly linked by index)
+  int activeHead = VOICE_NONE;
+  int activeTail = VOICE_NONE;
+  int activeNext[MAX_VOICES];
+  int activePrev[MAX_VOICES];
+  int activeCount = 0;
+
+  // Held List (doubly linked by index)
+  int heldHead = VOICE_NONE;
+  int heldTail = VOICE_NONE;
+  int heldNext[MAX_VOICES];
+  int heldPrev[MAX_VOICES];
+  bool inHeld[MAX_VOICES];
+
+  // Release Heap (heapPos: slot per voice, -1 when not releasing)
+  int heap[MAX_VOICES];
+  int heapPos[MAX_VOICES];
+  int heapSize = 0;
+  uint32_t silentAt[MAX_VOICES];
+  uint32_t clock = 0;
+
+  // Free Stack
+  int freeStack[MAX_VOICES];
+  int freeCount = 0;
+
+  // Note Map
+  int8_t noteVoice[STRING_COUNT];
+};
+
+#endif
@@ -1,7 +1,15 @@
 // --- ESP32 CYD Autoharp ---
+#include "AudioEngine.h"
+#include "AudioOutput.h"
+#include "AudioRing.h"
+#include "Benchmark.h"
 #include "Config.h"
+#include "LatencyProbe.h"
+#include "Profiler.h"
 #include "Settings.h"
+#include "SplitRender.h"
 #include "SynthVoice.h"
+#include "Upsampler.h"
 #include <Arduino.h>
 #include <Preferences.h>
 #include <SPI.h>
@@ -12,17 +20,11 @@
 // --- AUDIO CONFIG ---
 // Both Included for Dynamic Switching
 #include "BluetoothA2DPSource.h"
-#include "soc/rtc_io_reg.h"
-#include "soc/sens_reg.h"
 #include <driver/dac.h>
 #include <driver/i2s.h>
 BluetoothA2DPSource a2dp_source;
 bool isBluetoothActive = false; // Track if BT was ever started
 
-// Wired Audio Globals
-hw_timer_t *timer = nullptr;
-portMUX_TYPE timerMux = portMUX_INITIALIZER_UNLOCKED;
-
 // Boot State
 enum AudioTarget {
   TARGET_SPLASH,
@@ -43,7 +45,6 @@ AudioTarget audioTarget = TARGET_SPLASH;
 TFT_eSPI tft = TFT_eSPI();
 XPT2046_Touchscreen ts(XPT2046_CS, XPT2046_IRQ);
 
-SynthVoice voices[MAX_VOICES];
 float baseFreqs[STRING_COUNT];
 int octaveShift = 0;
 int latchedOctaveShift = 0; // Locked octave for Drone/Arp Latch
@@ -51,30 +52,6 @@ uint16_t activeChord = 0;
 uint16_t currentChordMask = 0xFFFF;
 int activeButtonIndex = -1;
 
-// --- Sound Profiles ---
-// Bluetooth: High Fidelity, Balanced, Lush
-// Bluetooth: High Fidelity, Balanced, Lush
-SoundProfile btProfile = {
-    0.90f, // Saw
-    0.50f, // Square
-    0.40f, // Sine (Deep Reduction for Polyphony)
-    0.80f, // Tri
-    0.55f, // Master (Headroom for Delay)
-    2.0f   // Release
-};
-
-// Speaker: Loud, Punchy, Short Tail
-SoundProfile spkProfile = {
-    0.19f, // Saw
-    0.30f, // Square
-    0.20f, // Sine (Deep Reduction)
-    0.52f, // Tri
-    0.65f, // Master
-    2.0f   // Release
-};
-
-SoundProfile *currentProfile = &btProfile; // Default to BT settings mostly
-
 Waveform currentWaveform = WAVE_SAW;
 uint32_t wavePressStart = 0; // For long press
 uint32_t arpPressStart = 0;  // For long press
@@ -120,53 +97,31 @@ void selectWaveform(int w) {
   updateDerivedParameters();
 }
 
-// --- Audio Buffer ---
-#define AUDIO_BUF_SIZE 4096
-// volatile uint8_t audioBuffer[AUDIO_BUF_SIZE];
-volatile uint8_t *audioBuffer = NULL; // Heap Allocated for Safety
-volatile int bufReadHead = 0;
-volatile int bufWriteHead = 0;
-volatile uint32_t isrCount = 0;
+// --- Audio Output State ---
 volatile uint32_t lastFillDuration = 0; // Performance Tracking
 TaskHandle_t audioTaskHandle = NULL;
+volatile bool audioParkRequest = false; // UI: hold the audio task
+volatile bool audioParked = false;      // Audio task: idle, outside render()
 
-volatile float globalPulseWidth = 0.5f;
+float globalPulseWidth = 0.5f;
 volatile int activeSampleRate = SAMPLE_RATE; // Default to 22050
 
-// Filter State (Chamberlin SVF) - MOVED BELOW
-// Removing duplicates caused by previous edit error
-// Filter State (Chamberlin SVF)
-// Filter State (Chamberlin SVF)
-volatile float svf_low = 0;
-volatile float svf_band = 0;
-volatile float svf_f = 0.5f;  // Cutoff coefficient
-volatile float svf_q = 0.22f; // Resonance
-
-// Tape Wobble State
-volatile float wowPhase = 0.0f;
-volatile float flutterPhase = 0.0f;
-volatile float wowInc = 2.0f * PI * 2.0f / 22050.0f;
-volatile float flutterInc = 2.0f * PI * 3.0f / 22050.0f;
+// Filter, LFO, Wobble, Tremolo and Delay state live in AudioEngine
 
 // Sound Design Tools State
 bool fxDrive = false;
 bool fxTrem = false;
 bool fxLFO = false;
 
-// Tremolo State
-float tremPhase = 0.0f;
-volatile float tremInc = 2.0f * PI * 5.0f / 22050.0f; // Updated by Params
-
-// Global LFO State
-float globalLfoPhase = 0.0f;
-volatile float globalLfoVal = 0.0f;
-volatile float globalLfoInc =
-    2.0f * PI * 0.35f / SAMPLE_RATE;   // Updated by Params
-volatile float globalLfoDepth = 0.30f; // New Global for LDR Mod
-
 // Master Volume (User Controlled)
 float masterVolume = 0.8f;
 
+// Same-note retrigger keeps oscillator phase + envelope level
+bool softRestart = true;
+
+// Output resolution for early voice retirement (set with the output)
+float outputLsb = 1.0f / 127.0f;
+
 // --- ARPEGGIATOR STATE ---
 // ArpMode defined in Config.h
 // ArpMode defined in Config.h
@@ -192,25 +147,6 @@ struct SparkleEvent {
 #define MAX_SPARKS 32
 SparkleEvent pendingSparks[MAX_SPARKS];
 
-// --- AUDIO CONFIG DATA ---
-struct AudioConfigPreset {
-  const char *name;
-  int i2s_num;
-  int bck;
-  int ws;
-  int dout;
-  int format; // 0=I2S_Norm, 1=LSB (PT8211), 2=DAC_INT
-};
-
-#define AUDIO_PRESET_COUNT 5
-AudioConfigPreset audioPresets[AUDIO_PRESET_COUNT] = {
-    {"Internal DAC", 0, 26, 25, 22,
-     2}, // Mode 2 = DAC. Pins irrelevant but stored.
-    {"MAX98357 Std", 0, 26, 25, 22, 0},
-    {"PCM5102 Std", 0, 26, 25, 22, 0}, // Often same as MAX, but useful label
-    {"Custom 1", 0, 26, 25, 33, 0},
-    {"PT8211 LSB", 0, 26, 25, 22, 1}};
-
 bool isAudioTestRunning = false;
 uint32_t lastAudioTestClick = 0;
 // We need a pointer to AudioOutputI2S if we were using the library from Plus.
@@ -249,54 +185,15 @@ void drawTransposeButton();
 void updateButtonVisuals();
 void drawInterface();
 
-// Delay State
-#define MAX_DELAY_MS 1200
-// Downsample Factor: 6 for "Lo-Fi" efficiency (Allows 12 voices on BT)
-#define DELAY_DOWNSAMPLE 6
-#define MAX_DELAY_LEN (int)(44100 * MAX_DELAY_MS / 1000 / DELAY_DOWNSAMPLE)
-// Using int16_t for buffer to save RAM (26KB now, super safe) + Super Vintage
-// Grit
-int16_t delayBuffer[MAX_DELAY_LEN];
-int delayHead = 0;
-int delayTick = 0; // For downsampling
+// Delay State (Buffer lives in AudioEngine)
 int delayMode = 0; // 0=Off, 1=300ms, 2=600ms, 3=900ms, 4=1200ms
 volatile float wobbleDepth = 0.0025f; // Default 0.25%
-volatile float delayLpfState = 0.0f;  // For feedback damping
 int activeSliderIdx = -1;             // To lock onto a slider during drag
 
 // UI State
 int lastTouchedString = -1;
 int lastChordBtn = -1; // Global for reset on release
 
-// --- PERFORMANCE GOVERNOR ---
-int maxPolyphony = MAX_VOICES;
-float cpuLoad = 0.0f; // 0.0 to 1.0 (Target < 0.8)
-uint32_t lastLoadCheck = 0;
-
-// Strum Rate Detection
-uint32_t noteTriggerTimes[5] = {0};
-int noteTriggerHead = 0;
-
-bool detectFastStrum() {
-  // Check span of last 5 notes
-  uint32_t minT = 0xFFFFFFFF;
-  uint32_t maxT = 0;
-  int count = 0;
-  for (int i = 0; i < 5; i++) {
-    if (noteTriggerTimes[i] > 0) {
-      if (noteTriggerTimes[i] < minT)
-        minT = noteTriggerTimes[i];
-      if (noteTriggerTimes[i] > maxT)
-        maxT = noteTriggerTimes[i];
-      count++;
-    }
-  }
-  if (count < 4)
-    return false;
-
-  // If 4+ notes occurred within 200ms (50ms avg interval), that's a fast strum
-  return (maxT - minT) < 200;
-}
 // Helper for mapFloat
 float mapFloat(float x, float in_min, float in_max, float out_min,
                float out_max) {
@@ -325,15 +222,32 @@ int getGlobalNoteIndexSafe(int sIdx) {
   return constrain(idx, 0, STRING_COUNT - 1);
 }
 
-void releaseLatchedVoices() {
-  for (int v = 0; v < MAX_VOICES; v++) {
-    if (voices[v].active) {
-      voices[v].isLatchedArp = false;
-      voices[v].release();
-    }
-  }
+// --- VOICE EVENTS (Applied by the audio engine at block boundaries) ---
+void postVoiceEvent(NoteEventType type) {
+  NoteEvent e;
+  e.type = type;
+  audioEngine.post(e);
 }
 
+void postNoteOn(VoiceRole role, float freq, int noteIdx, float attack,
+                float decay, float sustain, float release) {
+  NoteEvent e;
+  e.type = EVT_NOTE_ON;
+  e.role = role;
+  e.freq = freq;
+  e.noteIdx = noteIdx;
+  e.waveform = currentWaveform;
+  e.pw = globalPulseWidth;
+  e.attack = attack;
+  e.decay = decay;
+  e.sustain = sustain;
+  e.release = release;
+  e.touchTime = latencyProbe.takeTouch();
+  audioEngine.post(e);
+}
+
+void releaseLatchedVoices() { postVoiceEvent(EVT_RELEASE_ALL); }
+
 // --- SPARKLE HELPER ---
 void scheduleSpark(uint32_t delayMs, float freq, int sIdx, float rel,
                    float vel) {
@@ -366,546 +280,211 @@ void setupSpeaker(); // Existing? No, check if defined.
 // Existing setupSpeaker() might not exist in Drone? It seems Drone uses
 // 'audioTarget' switch in setup/loop. I'll check setup() later.
 
+// (Re)start the wired I2S output with the given preset
 void applyAudioPreset(int index) {
-  // STUB: In V5 Drone, audio is currently fixed to DAC via onTimer.
-  // To support I2S switching, we'd need to overhaul the audio engine.
-  // For now, we save the preference, but the engine ignores it (or we implement
-  // later). We can at least print it.
-  if (index >= 0 && index < AUDIO_PRESET_COUNT) {
-    Serial.printf(
-        "Applying Audio Preset: %s (Not fully supported in Drone Engine yet)\n",
-        audioPresets[index].name);
-  }
+  if (index < 0 || index >= AUDIO_PRESET_COUNT)
+    return;
+  Serial.printf("Applying Audio Preset: %s\n", audioPresets[index].name);
+
+  // A2DP owns the radio/CPU in BT mode; preset takes effect on Speaker boot
+  if (isBluetoothActive)
+    return;
+
+  activeSampleRate = SAMPLE_RATE;
+  audioOutput.begin(index, activeSampleRate, settings.lowLatency);
+  outputLsb = audioOutput.lsb();
+  audioEngine.publishParams();
+
+  // Audio task sleeps while output is off: wake it
+  if (audioTaskHandle != NULL)
+    xTaskNotifyGive(audioTaskHandle);
 }
 
 // Update Derived Parameters (Call after changing activeParams)
 void updateDerivedParameters() {
-  // Update Filter
-  // svf_f = 2 * sin(PI * Fc / Fs)
-  svf_f = 2.0f * sin(PI * activeParams.filterCutoff / (float)activeSampleRate);
-  if (svf_f > 0.95f)
-    svf_f = 0.95f;
-
-  // Update Resonance (q)
-  // q = 1.0 - res. High Res = Low q.
   // Clamp Res to 0.95 to avoid explosion
   if (activeParams.filterRes > 0.95f)
     activeParams.filterRes = 0.95f;
-  svf_q = 1.0f - activeParams.filterRes;
-
-  // Update Rates
-  globalLfoInc = 2.0f * PI * activeParams.lfoRate / (float)activeSampleRate;
-  tremInc = 2.0f * PI * activeParams.tremRate / (float)activeSampleRate;
-  wowInc = 2.0f * PI * 2.0f / (float)activeSampleRate;
-  flutterInc = 2.0f * PI * 3.0f / (float)activeSampleRate;
-
-  // Update Voice Envelopes (Global update for simplicity)
-  for (int i = 0; i < MAX_VOICES; i++) {
-    voices[i].attackTime = activeParams.attackTime;
-    voices[i].releaseTime = activeParams.releaseTime;
-    // Re-calc rates
-    voices[i].attackRate = 1.0f / (activeParams.attackTime * activeSampleRate);
-    voices[i].releaseRate =
-        1.0f / (activeParams.releaseTime * activeSampleRate);
-    voices[i].setWaveform(currentWaveform); // Fix visual only switching
-  }
-}
 
-// --- AUDIO GENERATION LOGIC (Shared) ---
-// Returns a single float sample (-1.0 to 1.0) mixed from all voices + Filtered
-float generateMixedSample(float pitchMod, float pwMod, float filterMod,
-                          float resMod) {
-  float mixedSample = 0.0f;
-  int activeCount = 0;
-
-  for (int i = 0; i < MAX_VOICES; i++) {
-    if (voices[i].active) {
-      mixedSample += voices[i].getSample(pitchMod, pwMod);
-      activeCount++;
-    }
-  }
+  // Publish Filter + Modulator Snapshot to the audio core
+  audioEngine.publishParams();
 
-  if (activeCount > 0) {
-    // Dynamic Gain Scaling for Polyphony > 4
-    float polyScale = 1.0f;
-    if (activeCount > 4) {
-      polyScale = 4.0f / (float)activeCount;
-    }
-    mixedSample *= (currentProfile->masterGain * polyScale);
-  }
+  // Update Voice Envelopes (Applied to all voices on the audio side)
+  NoteEvent e;
+  e.type = EVT_ENV_PARAMS;
+  e.attack = activeParams.attackTime;
+  e.release = activeParams.releaseTime;
+  e.waveform = currentWaveform; // Fix visual only switching
+  audioEngine.post(e);
+}
 
-  // Anti-Denormal noise
-  mixedSample += 1.0e-18f;
+// --- BLUETOOTH FEED (Always Compile) ---
+// The audio task renders ahead into btFeed in fixed quanta; the A2DP
+// callback (BT stack task) only copies frames out. The render cost no longer
+// depends on how many frames the stack asks for, so the governor budgets
+// against a fixed quantum and a slow block is absorbed by the ring.
+#define BT_FEED_LEN 2048 // Frames (power of two, ~46ms @ 44.1kHz)
+#define BT_QUANTUM 64    // Engine samples per render (128 frames)
+#define BT_DEPTH_MIN 256 // Render-ahead limits (frames)
+#define BT_DEPTH_MAX (BT_FEED_LEN - BT_QUANTUM * 2)
+#define BT_DEPTH_DEFAULT 1024
+
+HalfBandUpsampler btUpsampler; // SAMPLE_RATE -> 44.1kHz
+AudioRing<Frame, BT_FEED_LEN> btFeed;
+volatile int btFeedDepth = BT_DEPTH_DEFAULT; // Serial "btdepth <frames>"
+
+// Output Adapter: one engine sample -> int16 Stereo Frame
+static inline void writeBtFrame(Frame &frame, float sample) {
+  // Clip hard
+  if (sample > 1.0f)
+    sample = 1.0f;
+  if (sample < -1.0f)
+    sample = -1.0f;
+
+  // Final Volume Reduction for Bluetooth (65% of max)
+  sample *= 0.65f;
+
+  // Convert to 16-bit
+  int16_t out = (int16_t)(sample * 30000.0f);
+
+  // Stereo Frame
+  frame.channel1 = out; // Left
+  frame.channel2 = out; // Right
+}
 
-  // Apply Filter Cutoff
-  float f = svf_f;
-  if (f > 0.85f)
-    f = 0.85f; // More conservative limit for stability
-  if (f < 0.005f)
-    f = 0.005f;
+void setBtFeedDepth(int frames) {
+  if (frames < BT_DEPTH_MIN)
+    frames = BT_DEPTH_MIN;
+  if (frames > BT_DEPTH_MAX)
+    frames = BT_DEPTH_MAX;
+  btFeedDepth = frames;
+}
 
-  svf_low += f * svf_band;
+// Audio task: top the ring up to the render-ahead depth
+void fillBtFeed() {
+  float block[BT_QUANTUM];
+  float up[BT_QUANTUM * 2];
+  Frame frames[BT_QUANTUM * 2];
 
-  // Waveform-dependent Resonance Tuning
-  float baseRes = activeParams.filterRes * resMod;
-  if (baseRes > 0.95f)
-    baseRes = 0.95f;
-  if (baseRes < 0.01f)
-    baseRes = 0.01f;
+  while (btFeed.fill() + BT_QUANTUM * 2 <= (uint32_t)btFeedDepth) {
+    // Render at SAMPLE_RATE, upsample 2x to BT_SAMPLE_RATE
+    audioEngine.render(block, BT_QUANTUM);
+    uint32_t outStart = profCycles();
+    PROF_DECLARE(profT);
+    btUpsampler.process(block, up, BT_QUANTUM);
+    for (int i = 0; i < BT_QUANTUM * 2; i++) {
+      writeBtFrame(frames[i], up[i]);
+    }
 
-  // Convert Res to Q (damping). Low Damping = High Res.
-  float q = 1.0f - baseRes;
+    PROF_RECORD(PROF_OUT_BT, profCycles() - profT);
+    audioEngine.governor.learnOutput(profCycles() - outStart, BT_QUANTUM);
 
-  // --- v3.5 Q-Compensation Logic ---
-  if (currentWaveform == WAVE_SAW) {
-    q = q * 2.6f; // +30%
-  } else if (currentWaveform == WAVE_SINE) {
-    q = q * 3.9f; // +30%
-  }
-
-  // Profile Specific Safety
-  if (currentProfile == &spkProfile) {
-    q = q * 2.34f; // +30% from 1.8f
-  } else if (currentProfile == &btProfile) {
-    q = q * 2.275f; // +30% from 1.75f
-    if (currentWaveform == WAVE_SINE)
-      q = q * 1.95f; // +30% from 1.5f
-    else if (currentWaveform == WAVE_SQUARE)
-      q = q * 1.95f;
-    else if (currentWaveform == WAVE_TRIANGLE)
-      q = q * 1.56f; // +30% from 1.2f
-  }
-
-  if (q > 1.0f)
-    q = 1.0f;
-
-  float high = mixedSample - svf_low - (q * svf_band);
-  svf_band += f * high;
-
-  // Clip (Hard Clip Filter States)
-  if (svf_low > 2.0f)
-    svf_low = 2.0f;
-  else if (svf_low < -2.0f)
-    svf_low = -2.0f;
-  if (svf_band > 2.0f)
-    svf_band = 2.0f;
-  else if (svf_band < -2.0f)
-    svf_band = -2.0f;
-
-  return svf_low;
+    btFeed.write(frames, BT_QUANTUM * 2);
+    latencyProbe.setOutputMark(btFeed.written());
+  }
 }
 
-// --- BLUETOOTH CALLBACK (Always Compile) ---
 // The A2DP library calls this to get data.
 // Signature match: int32_t (*)(Frame *data, int32_t len) where len is frame
 // count
 int32_t bt_data_stream_callback(Frame *data, int32_t len) {
-  // START PROFILE
-  uint32_t startT = micros();
-
-  if (delayBuffer == NULL)
-    return len; // Safety Check
-
-  for (int i = 0; i < len; i++) {
-    // --- LFO Generation ---
-    globalLfoPhase += globalLfoInc;
-    if (globalLfoPhase >= 2.0f * PI)
-      globalLfoPhase -= 2.0f * PI;
-
-    float lfoVal = 0.0f;
-    if (activeParams.lfoType == LFO_SINE) {
-      lfoVal = sin(globalLfoPhase);
-    } else if (activeParams.lfoType == LFO_SQUARE) {
-      lfoVal = (globalLfoPhase < PI) ? 1.0f : -1.0f;
-    } else if (activeParams.lfoType == LFO_RAMP) {
-      lfoVal = (globalLfoPhase / PI) - 1.0f;
-    } else if (activeParams.lfoType == LFO_NOISE) {
-      lfoVal = (float)random(-100, 100) / 100.0f;
-    }
-    globalLfoVal = lfoVal;
-
-    // --- Tape Wobble ---
-    wowPhase += wowInc;
-    if (wowPhase >= 6.283185307f)
-      wowPhase -= 6.283185307f;
-    flutterPhase += flutterInc;
-    if (flutterPhase >= 6.283185307f)
-      flutterPhase -= 6.283185307f;
-    float wobble = (sin(wowPhase) + sin(flutterPhase)) *
-                   0.0007f; // significantly reduced wobble
-
-    // --- Modulators ---
-    float pitchMod = 1.0f + wobble;
-    float pwMod = 0.0f;
-    float filterMod = 1.0f;
-    float resMod = 1.0f;
-
-    if (fxLFO) {
-      // Using same generic depth as Wired
-      float depth = activeParams.lfoDepth; // Local or Global? Global is safe.
-      if (activeParams.lfoTarget == TARGET_PITCH) {
-        pitchMod += lfoVal * depth * 0.1f;
-      } else if (activeParams.lfoTarget == TARGET_FOLD) {
-        pwMod += lfoVal * depth * 0.4f;
-      } else if (activeParams.lfoTarget == TARGET_FILTER) {
-        filterMod += lfoVal * depth * 0.8f;
-      } else if (activeParams.lfoTarget == TARGET_RES) {
-        resMod += lfoVal * depth * 0.5f;
-      }
-    }
-
-    // Wave/Fold Parameter Mapping
-    float totalPW = activeParams.waveFold;
-    float derivedPwMod = (totalPW - 0.5f) + pwMod;
-
-    float sample =
-        generateMixedSample(pitchMod, derivedPwMod, filterMod, resMod);
-
-    // FX: Drive
-    if (fxDrive) {
-      float drive = 1.0f + activeParams.driveAmount * 3.0f;
-      sample *= drive;
-      if (sample > 1.2f)
-        sample = 1.2f;
-      if (sample < -1.2f)
-        sample = -1.2f;
-      sample = sample - (sample * sample * sample) * 0.333f;
-    }
-
-    // Delay Processing
-    delayTick++;
-    if (delayTick >= DELAY_DOWNSAMPLE)
-      delayTick = 0;
-
-    float delayed = 0.0f;
-    if (delayMode > 0 && delayBuffer != 0) {
-      int delayMs = delayMode * 300;
-      int delaySamples = (activeSampleRate / DELAY_DOWNSAMPLE * delayMs) / 1000;
-      int readPos = (delayHead - delaySamples + MAX_DELAY_LEN) % MAX_DELAY_LEN;
-      delayed = (float)delayBuffer[readPos] * 3.3333e-5f;
-    }
-
-    float dry = sample;
-    sample = dry + delayed * 0.5f;
-
-    // FX: Tremolo
-    if (fxTrem) {
-      tremPhase += tremInc;
-      if (tremPhase >= 6.283185307f)
-        tremPhase -= 6.283185307f;
-      float mod = 1.0f + 0.5f * sin(tremPhase);
-      sample *= mod * 0.7f;
-    }
-
-    // Delay Write
-    if (delayTick == 0 && delayBuffer != 0) {
-      if (delayMode > 0) {
-        float fbAmt = activeParams.delayFeedback;
-        float fb = delayed * fbAmt + dry * 0.7f;
-
-        // Damping (One-pole LPF ~0.66 coeff)
-        delayLpfState = delayLpfState * 0.34f + fb * 0.66f;
-        fb = delayLpfState;
-
-        if (fb > 1.0f)
-          fb = 1.0f;
-        if (fb < -1.0f)
-          fb = -1.0f;
-        delayBuffer[delayHead] = (int16_t)(fb * 30000.0f);
-      } else {
-        delayBuffer[delayHead] = 0;
-      }
-      delayHead = (delayHead + 1) % MAX_DELAY_LEN;
-    }
-
-    // Master Volume
-    sample *= masterVolume;
-
-    // --- Audio Test Tone (BT) ---
-    if (isAudioTestRunning) {
-      static float testPhaseBT = 0;
-      testPhaseBT += 2.0f * PI * 440.0f / 44100.0f;
-      if (testPhaseBT >= 2.0f * PI)
-        testPhaseBT -= 2.0f * PI;
-      sample += sin(testPhaseBT) * 0.3f;
-    }
-
-    // Clip hard
-    if (sample > 1.0f)
-      sample = 1.0f;
-    if (sample < -1.0f)
-      sample = -1.0f;
-
-    // Final Volume Reduction for Bluetooth (65% of max)
-    sample *= 0.65f;
-
-    // Convert to 16-bit
-    int16_t out = (int16_t)(sample * 30000.0f);
-
-    // Stereo Frame
-    data[i].channel1 = out; // Left
-    data[i].channel2 = out; // Right
-  }
-
-  // --- GOVERNOR LOGIC (Duplicated for BT Context) ---
-  // BT callback shouldn't take > 80% of its budget.
-  // Budget depends on buffer size (len).
-  // len samples @ 44.1k = len * 22.6us.
-  // If len=512, budget ~ 11ms.
-  uint32_t elapsed = micros() - startT;
-  float budget = (float)len * (1000000.0f / 44100.0f);
-  float load = (float)elapsed / budget;
-
-  // Smoothing
-  cpuLoad = cpuLoad * 0.8f + load * 0.2f;
-
-  // Throttle
-  // Granular Governor (User Requested Table)
-  int targetPoly = 18;
-  if (cpuLoad < 0.50f)
-    targetPoly = 18;
-  else if (cpuLoad < 0.55f)
-    targetPoly = 16;
-  else if (cpuLoad < 0.60f)
-    targetPoly = 14;
-  else if (cpuLoad < 0.65f)
-    targetPoly = 12;
-  else if (cpuLoad < 0.70f)
-    targetPoly = 10;
-  else if (cpuLoad < 0.75f)
-    targetPoly = 8;
-  else if (cpuLoad < 0.80f)
-    targetPoly = 6;
-  else
-    targetPoly = 4; // > 80% Emergency
+  if (len <= 0)
+    return 0;
 
-  // Strum Rate Intervention
-  if (detectFastStrum()) {
-    // Fast strum detected! Anticipate load spike.
-    // Cap at 12 to prevent buffer overrun during rapid allocation
-    if (targetPoly > 12)
-      targetPoly = 12;
+  uint32_t got = btFeed.read(data, (uint32_t)len);
+  if (got < (uint32_t)len) {
+    // Underrun: pad with silence (counted in btFeed stats)
+    memset(&data[got], 0, (len - got) * sizeof(Frame));
   }
+  latencyProbe.handedOff(btFeed.consumed());
 
-  maxPolyphony = targetPoly;
-
+  // Wake the audio task to refill
+  if (audioTaskHandle != NULL)
+    xTaskNotifyGive(audioTaskHandle);
   return len;
 }
 
-// --- WIRED/DAC CALLBACKS (Always Compile) ---
-
-// --- ISR: Read Buffer ---
-// --- ISR: Read Buffer ---
-void ARDUINO_ISR_ATTR onTimer() {
-  portENTER_CRITICAL_ISR(&timerMux);
-  isrCount++; // DEBUG: Count interrupts
-
-  // Only play if buffer has data
-  if (bufReadHead != bufWriteHead) {
-    uint8_t sample = audioBuffer[bufReadHead];
-    bufReadHead = (bufReadHead + 1) % AUDIO_BUF_SIZE;
+// --- WIRED/I2S OUTPUT (Always Compile) ---
 
-    // Direct Register Write (Fastest) for jitter reduction
-    SET_PERI_REG_BITS(RTC_IO_PAD_DAC2_REG, RTC_IO_PDAC2_DAC, sample,
-                      RTC_IO_PDAC2_DAC_S);
-  } else {
-    // Underrun (Silence)? Or repeat last?
-    // Doing nothing maintains last voltage.
-  }
-
-  // Underrun: Do nothing
-  portEXIT_CRITICAL_ISR(&timerMux);
-}
-
-// --- Audio Generation Task (Called in loop) ---
-// --- Audio Generation Task (Called in loop) ---
-// --- Audio Generation Task (Burst Mode) ---
-// --- Audio Generation Task (Burst Mode) ---
+// --- Audio Generation Task (I2S DMA) ---
 void fillAudioBuffer() {
   uint32_t startT = micros();
 
-  // 1. Snapshot Heads
-  int r = bufReadHead;
-  int w = bufWriteHead;
-
-  // 2. Calculate Available Space
-  int freeSpace = (r - w + AUDIO_BUF_SIZE - 1) % AUDIO_BUF_SIZE;
-
-  // 3. Decide Burst Size
-  int samplesToFill = 2048;
-  if (samplesToFill > freeSpace)
-    samplesToFill = freeSpace;
-
-  if (samplesToFill <= 0)
-    return;
-
-  // 4. Tight Generation Loop
-  for (int i = 0; i < samplesToFill; i++) {
-    // --- LFO Generation ---
-    globalLfoPhase += globalLfoInc;
-    if (globalLfoPhase >= 2.0f * PI)
-      globalLfoPhase -= 2.0f * PI;
-
-    float lfoVal = 0.0f;
-    if (activeParams.lfoType == LFO_SINE) {
-      lfoVal = sin(globalLfoPhase);
-    } else if (activeParams.lfoType == LFO_SQUARE) {
-      lfoVal = (globalLfoPhase < PI) ? 1.0f : -1.0f;
-    } else if (activeParams.lfoType == LFO_RAMP) {
-      lfoVal = (globalLfoPhase / PI) - 1.0f;
-    } else if (activeParams.lfoType == LFO_NOISE) {
-      lfoVal = ((float)random(1000) / 500.0f) - 1.0f;
-    }
-
-    // --- Apply LFO Targets ---
-    float pitchMod = 1.0f; // Base multiplier
-    float pwMod = 0.0f;
-    float filterMod = 0.0f;
-    float resMod = 1.0f;
-
-    // effectiveDepth calculated
-    float effectiveDepth = activeParams.lfoDepth * globalLfoDepth;
-
-    if (activeParams.lfoTarget == TARGET_PITCH) {
-      pitchMod = 1.0f + (lfoVal * effectiveDepth * 0.1f);
-    } else if (activeParams.lfoTarget == TARGET_FOLD) {
-      if (activeParams.lfoType == LFO_SQUARE)
-        pwMod = (lfoVal > 0) ? activeParams.lfoDepth : 0.0f;
-      else
-        pwMod = lfoVal * effectiveDepth * 0.4f;
-    } else if (activeParams.lfoTarget == TARGET_FILTER) {
-      filterMod = lfoVal * effectiveDepth * 1000.0f;
-    } else if (activeParams.lfoTarget == TARGET_RES) {
-      resMod = 1.0f - (lfoVal * effectiveDepth * 0.5f);
-    }
-
-    // --- SYNTHESIS CORE ---
-    float sample = generateMixedSample(pitchMod, pwMod, filterMod, resMod);
-
-    // FX: Drive
-    if (fxDrive) {
-      float drive = 1.0f + activeParams.driveAmount * 3.0f;
-      sample *= drive;
-      if (sample > 1.2f)
-        sample = 1.2f;
-      if (sample < -1.2f)
-        sample = -1.2f;
-      sample = sample - (sample * sample * sample) * 0.333f;
-    }
-
-    // Delay Processing
-    delayTick++;
-    if (delayTick >= DELAY_DOWNSAMPLE)
-      delayTick = 0;
-
-    float delayed = 0.0f;
-    if (delayMode > 0 && delayBuffer != 0) {
-      int delayMs = delayMode * 300;
-      // Fixed: delaySamples should use activeSampleRate / DELAY_DOWNSAMPLE
-      int delaySamples = (activeSampleRate / DELAY_DOWNSAMPLE * delayMs) / 1000;
-      int readPos = (delayHead - delaySamples + MAX_DELAY_LEN) % MAX_DELAY_LEN;
-      delayed = (float)delayBuffer[readPos] * 3.3333e-5f;
-    }
-
-    float dry = sample;
-    sample = dry + delayed * 0.5f;
-
-    // FX: Tremolo
-    if (fxTrem) {
-      tremPhase += tremInc;
-      if (tremPhase >= 2.0f * PI)
-        tremPhase -= 2.0f * PI;
-      float mod = 1.0f + 0.5f * sin(tremPhase);
-      sample *= mod * 0.7f;
-    }
-
-    // Delay Write
-    if (delayTick == 0 && delayBuffer != 0) {
-      if (delayMode > 0) {
-        float fbAmt = activeParams.delayFeedback;
-        float fb = delayed * fbAmt + dry * 0.7f;
-        if (fb > 1.0f)
-          fb = 1.0f;
-        if (fb < -1.0f)
-          fb = -1.0f;
-        delayBuffer[delayHead] = (int16_t)(fb * 30000.0f);
-      } else {
-        delayBuffer[delayHead] = 0;
-      }
-      delayHead++;
-      if (delayHead >= MAX_DELAY_LEN)
-        delayHead = 0;
-    }
-
-    float totalSample = sample;
-
-    // Final Output Mapping
-    int out = 128 + (int)(totalSample * 127.0f);
-    if (out < 0)
-      out = 0;
-    if (out > 255)
-      out = 255;
-
-    // Write to Buffer
-    int currentWriteIdx = (w + i) % AUDIO_BUF_SIZE;
-    audioBuffer[currentWriteIdx] = (uint8_t)out;
-  }
-
-  // 5. Commit Write Head
-  bufWriteHead = (w + samplesToFill) % AUDIO_BUF_SIZE;
+  // Render one DMA buffer worth (the quantum), then hand it to I2S
+  float buf[I2S_DMA_BUF_LEN];
+  int n = audioOutput.quantum();
+  audioEngine.render(buf, n);
 
   lastFillDuration = micros() - startT;
 
-  // Preserve Governor Logic (Calculates Load even if ignored)
-  if (millis() - lastLoadCheck > 50) {
-    uint32_t elapsed = lastFillDuration;
-    float budget = (samplesToFill * 1000000.0f) / activeSampleRate;
-    float load = (float)elapsed / budget;
-    cpuLoad = cpuLoad * 0.9f + load * 0.1f;
-
-    int targetPoly = 18;
-    if (cpuLoad < 0.50f)
-      targetPoly = 18;
-    else if (cpuLoad < 0.60f)
-      targetPoly = 14;
-    else if (cpuLoad < 0.70f)
-      targetPoly = 10;
-    else
-      targetPoly = 6;
-
-    if (detectFastStrum()) {
-      if (targetPoly > 18)
-        targetPoly = 18;
-    }
-    maxPolyphony = targetPoly;
-    lastLoadCheck = millis();
-  }
+  // A DMA buffer is free (waitForSpace), so this doesn't block
+  uint32_t outStart = profCycles();
+  audioOutput.write(buf, n);
+  audioEngine.governor.learnOutput(profCycles() - outStart, n);
+  latencyProbe.handedOff();
 }
 
 // --- AUDIO TASK (High Priority / Core 0) ---
 // --- AUDIO TASK (High Priority / Core 0) ---
 void audioTask(void *parameter) {
   while (1) {
-    if (audioTarget == TARGET_SPEAKER && audioBuffer != NULL) {
-      // Hysteresis: Only fill if we have a decent chunk to write (e.g. 128
-      // samples) This prevents waking up every 45us to write 1 sample.
-      int r = bufReadHead;
-      int w = bufWriteHead;
-      int freeSpace = (r - w + AUDIO_BUF_SIZE - 1) % AUDIO_BUF_SIZE;
-
-      if (freeSpace > 128) {
+    if (audioParkRequest) {
+      // Output switch on the UI core (tables, sample rate, feed reset)
+      audioParked = true;
+      ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+      audioParked = false;
+      continue;
+    }
+    // Audio Config screen also renders so the Test Tone can check a preset
+    if ((audioTarget == TARGET_SPEAKER ||
+         audioTarget == TARGET_AUDIO_CONFIG) &&
+        audioOutput.isRunning()) {
+      // Woken by the I2S ISR (TX_DONE): one quantum per wakeup once the
+      // watermark of buffers is free
+      if (audioOutput.waitForSpace(pdMS_TO_TICKS(50)))
         fillAudioBuffer();
-        vTaskDelay(1); // Small yield
-      } else {
-        // Buffer is nearly full, sleep longer to let ISR consume
-        vTaskDelay(5);
-      }
+    } else if (isBluetoothActive) {
+      // Render ahead, then sleep until the A2DP callback drains the ring
+      // (timeout only as a safety net)
+      fillBtFeed();
+      ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(50));
+    } else if (audioOutput.needsRestart()) {
+      // Driver install failed (e.g. during an underrun recovery): retry
+      // with the normal-latency ring instead of parking the task
+      ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(I2S_RETRY_MS));
+      audioOutput.restart();
     } else {
-      vTaskDelay(10);
+      // Output off (menus): sleep until applyAudioPreset()
+      ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
     }
   }
 }
 
+// UI core: stop the audio task between blocks before touching state that
+// render() reads unlocked. Returns false if it didn't get there in time.
+#define AUDIO_PARK_TIMEOUT_MS 200
+static bool parkAudioTask() {
+  if (audioTaskHandle == NULL)
+    return true; // Not started yet (setup)
+  audioParkRequest = true;
+  xTaskNotifyGive(audioTaskHandle);
+  uint32_t start = millis();
+  while (!audioParked) {
+    if (millis() - start > AUDIO_PARK_TIMEOUT_MS) {
+      Serial.println("Audio task did not park");
+      return false;
+    }
+    delay(1);
+  }
+  return true;
+}
+
+static void resumeAudioTask() {
+  audioParkRequest = false;
+  if (audioTaskHandle != NULL)
+    xTaskNotifyGive(audioTaskHandle);
+}
+
 // --- UI Functions (Forward Declared implicitly by ordering) ---
 // --- UI Functions (Forward Declared implicitly by ordering) ---
 void drawWaveButton();      // Forward decl due to ordering
@@ -1615,6 +1194,23 @@ void drawAudioConfigScreen() {
   tft.fillRect(260, btnY, 40, btnH, TFT_DARKGREY);
   tft.drawRect(260, btnY, 40, btnH, TFT_WHITE);
   tft.drawString("OK", 260 + 20, btnY + btnH / 2);
+
+  // Latency Mode Btn
+  tft.fillRect(320, btnY, 140, btnH,
+               settings.lowLatency ? TFT_DARKGREEN : TFT_DARKGREY);
+  tft.drawRect(320, btnY, 140, btnH, TFT_WHITE);
+  tft.drawString(settings.lowLatency ? "Latency: LOW" : "Latency: NORMAL",
+                 320 + 70, btnY + btnH / 2);
+
+  // Output Buffer Status
+  char buf[64];
+  snprintf(buf, sizeof(buf), "DMA %d frames (%d ms) | Underruns %u (+%u)",
+           audioOutput.fillFrames(),
+           (audioOutput.fillFrames() * 1000) / SAMPLE_RATE,
+           (unsigned)audioOutput.underruns, (unsigned)audioOutput.recoveries);
+  tft.setTextDatum(TL_DATUM);
+  tft.setTextColor(TFT_LIGHTGREY);
+  tft.drawString(buf, 20, 240);
 }
 
 // --- DRAW CHORD BUTTONS ---
@@ -1752,10 +1348,10 @@ void handleButtonPress(int index) {
 // --- SETUP FUNCTIONS ---
 // --- SETUP FUNCTIONS ---
 void setupSpeaker() {
-  Serial.println("Initializing Speaker (Internal DAC)...");
+  Serial.println("Initializing Speaker (I2S DMA)...");
 
   // CRITICAL: Stop Bluetooth to free CPU/Radio
-  // DEEP CLEAN: Uninstall I2S driver to release DAC2 (GPIO 26)
+  // DEEP CLEAN: Uninstall I2S driver so AudioOutput can claim I2S0
   if (isBluetoothActive) {
     if (a2dp_source.is_connected()) {
       Serial.println("Stopping Bluetooth...");
@@ -1776,18 +1372,11 @@ void setupSpeaker() {
   currentProfile = &spkProfile;
   Serial.println("Sound Profile: SPEAKER (High Output)");
 
-  // EXPLICITLY ENABLE DAC (Steal back from I2S)
-  dac_output_enable(DAC_CHANNEL_2);
-
   // FORCE 22050Hz for Speaker Stability
+  parkAudioTask(); // May still be mid-render into btFeed
   activeSampleRate = 22050;
-
-  // SAFETY: Do not detach/reattach ISR. Just update period.
-  if (timer != NULL) {
-    timerAlarmWrite(timer, 1000000 / activeSampleRate, true);
-    timerAlarmEnable(
-        timer); // CRITICAL: Ensure timer is running if it was disabled
-  }
+  audioEngine.buildTables();
+  resumeAudioTask(); // Sleeps until applyAudioPreset() starts the output
 
   // CRITICAL: Enable Speaker Amp (Pin 4)
   pinMode(4, OUTPUT);
@@ -1810,15 +1399,8 @@ void setupSpeaker() {
 
   updateDerivedParameters();
 
-  // Clear and Reset Pointer
-  // Clear and Reset Pointer
-  bufReadHead = 0;
-  bufWriteHead = 2048; // Pre-fill offset to prevent immediate underrun race
-  for (int i = 0; i < AUDIO_BUF_SIZE; i++)
-    for (int i = 0; i < AUDIO_BUF_SIZE; i++)
-      audioBuffer[i] = 128;
-
-  // DAC is already initialized in setup(), nothing else needed here
+  // Start I2S DMA Output (Internal DAC or external I2S per saved preset)
+  applyAudioPreset(settings.audioProfileIndex);
 }
 
 // BT Connection State Callback
@@ -1873,25 +1455,33 @@ bool ssid_callback(const char *ssid, esp_bd_addr_t bd_addr, int rssi) {
 }
 
 void setupBluetooth(bool scanning = false) {
-  isBluetoothActive = true;
   Serial.println("Initializing Bluetooth...");
 
-  // FORCE 44.1kHz for Bluetooth (Standard A2DP)
-  activeSampleRate = 44100;
-
-  // CRITICAL: DISABLE Speaker Timer Interrupt!
+  // CRITICAL: Release Speaker I2S Output!
   // Prevents CPU starvation/conflict with BT Stack
-  if (timer != NULL) {
-    timerAlarmDisable(timer);
-    // timerDetachInterrupt(timer); // Caused re-attach issues in Speaker Mode
-  }
+  audioOutput.end();
 
-  updateDerivedParameters();
+  // Nothing renders while the tables and the feed switch over
+  parkAudioTask();
+  btFeed.clear();
+  btFeed.resetStats();
+  btUpsampler.reset();
+
+  // A2DP runs at 44.1kHz; the engine stays at SAMPLE_RATE and the
+  // audio task upsamples 2x into btFeed (halves synthesis cost)
+  activeSampleRate = SAMPLE_RATE;
+  audioEngine.buildTables();
+  outputLsb = 1.0f / (0.65f * 30000.0f); // writeBtFrame scaling
 
   // Set Profile (Only if not scanning? Actually scanning uses same profile)
+  // before publishing, so the first BT snapshot carries the BT profile
   currentProfile = &btProfile;
   Serial.println("Sound Profile: BLUETOOTH (High Fidelity)");
 
+  updateDerivedParameters();
+  isBluetoothActive = true;
+  resumeAudioTask(); // Start rendering ahead
+
   // Power Cycle BLE to clear stuck state
   a2dp_source.set_reset_ble(true);
 
@@ -2486,6 +2076,7 @@ void saveSettings();
 void loadSettings() {
   settings.begin(); // Initialize Preferences
   settings.load();
+  audioEngine.governor.setHeadroom(settings.headroom);
 }
 
 void saveSettings() { settings.save(); }
@@ -2583,6 +2174,7 @@ void setup() {
 
   Serial.println("Initializing Voices...");
   SynthVoice::initLUT();
+  audioEngine.buildTables();
 
   // Initialize Wave Presets
   for (int i = 0; i < 4; i++) {
@@ -2592,15 +2184,6 @@ void setup() {
   // Init Delay Buffer - Statically allocated now
   Serial.printf("Delay Buffer Size: %d bytes\n", MAX_DELAY_LEN * 2);
 
-  // ALLOCATE AUDIO BUFFER IN INTERNAL RAM (Critical for ISR)
-  audioBuffer = (uint8_t *)heap_caps_malloc(
-      AUDIO_BUF_SIZE, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
-  if (audioBuffer == NULL) {
-    Serial.println("FATAL: Failed to allocate Audio Buffer!");
-  } else {
-    memset((void *)audioBuffer, 128, AUDIO_BUF_SIZE);
-  }
-
   Serial.println("Initializing Display...");
   // Init Display
   tft.init();
@@ -2642,14 +2225,7 @@ void setup() {
     f *= k;
   }
 
-  // --- AUDIO TIMER SETUP (DAC) ---
-  timer = timerBegin(0, 80, true);
-  timerAttachInterrupt(timer, &onTimer, true);
-  timerAlarmWrite(timer, 1000000 / SAMPLE_RATE, true);
-  timerAlarmEnable(timer);
-
-  // Enable DAC Output
-  dac_output_enable(DAC_CHANNEL_2); // GPIO 26
+  // Wired output (I2S DMA) is started by setupSpeaker()/applyAudioPreset()
 
   // Show Boot Selection or Force Calibration
   delay(500);
@@ -2660,14 +2236,20 @@ void setup() {
   }
   // Boot screen handled above to allow SPI re-init sequence
 
+  // Optional split render: voice worker on Core 1 (serial "split").
+  // Installed before the audio task exists: the engine reads it unlocked.
+  if (splitRender.begin(1))
+    audioEngine.setSplit(&splitRender);
+  splitRender.setEnabled(settings.splitRender);
+
   // Start Audio Task (Core 0 to avoid Loop/UI contention on Core 1)
-  xTaskCreatePinnedToCore(audioTask,  /* Function to implement the task */
-                          "AudioGen", /* Name of the task */
-                          10000,      /* Stack size (increased for safety) */
-                          NULL,       /* Task input parameter */
-                          20,         /* Priority (High/Real-Time) */
-                          NULL,       /* Task handle. */
-                          0);         /* Core where the task should run */
+  xTaskCreatePinnedToCore(audioTask,        /* Function to implement */
+                          "AudioGen",       /* Name of the task */
+                          10000,            /* Stack (increased for safety) */
+                          NULL,             /* Task input parameter */
+                          20,               /* Priority (High/Real-Time) */
+                          &audioTaskHandle, /* Handle (notified on start) */
+                          0);               /* Core where the task runs */
 }
 // --- HELPER FUNCTION: Find String Visual ID ---
 int getClosestStringIndex(float targetFreq) {
@@ -2697,7 +2279,7 @@ void triggerNote(int sIdx) {
   int gIdx = getGlobalNoteIndexSafe(sIdx);
   float freq = baseFreqs[gIdx];
 
-  // Anti-Aliasing Cap: 4.8kHz for BT (44.1k), 3.2kHz for Speaker (32k/22k)
+  // Anti-Aliasing Cap: 4.8kHz for BT (upsampled), 3.2kHz for Speaker
   float cap = (currentProfile == &spkProfile) ? 3200.0f : 4800.0f;
   if (freq > cap)
     freq = cap;
@@ -2739,56 +2321,6 @@ void triggerNote(int sIdx) {
   if (freq > 15500.0f)
     freq = 15500.0f; // Clamp below Nyquist (C10 is ~16.7k)
 
-  // --- GOVERNOR: Update Strum History ---
-  noteTriggerTimes[noteTriggerHead] = millis();
-  noteTriggerHead = (noteTriggerHead + 1) % 5;
-
-  // Find Voice
-  int vIdx = -1;
-  // Dynamic Governor Check (Tiered)
-  // Max Polyphony is determined by the Load Governor in fillAudioBuffer
-  int effectiveLimit = maxPolyphony;
-
-  // Count Active first
-  int activeCount = 0;
-  for (int v = 0; v < MAX_VOICES; v++)
-    if (voices[v].active)
-      activeCount++;
-
-  // 1. Try to find Inactive (if under limit)
-  if (activeCount < effectiveLimit) {
-    for (int v = 0; v < MAX_VOICES; v++) {
-      if (!voices[v].active) {
-        vIdx = v;
-        break;
-      }
-    }
-  }
-  // 2. Stealing Logic (If capped OR no empty slots)
-  if (vIdx == -1) {
-    // Priority A: Steal Released (Not Held) & Unlatched
-    for (int v = 0; v < MAX_VOICES; v++) {
-      if (voices[v].active && !voices[v].held && !voices[v].isLatchedArp) {
-        vIdx = v;
-        break;
-      }
-    }
-  }
-
-  if (vIdx == -1) {
-    // Priority B: Steal Any Unlatched (Oldest/First Found)
-    for (int v = 0; v < MAX_VOICES; v++) {
-      if (voices[v].active && !voices[v].isLatchedArp) {
-        vIdx = v;
-        break;
-      }
-    }
-  }
-
-  // Priority C: Desperation (Steal 0) if everything is latched?
-  if (vIdx == -1)
-    vIdx = 0;
-
   // UNLATCH logic removed per user request: Manual strum no longer kills Arp
   // Latch
   /*
@@ -2799,12 +2331,9 @@ void triggerNote(int sIdx) {
   }
   */
 
-  // Trigger Note
-  voices[vIdx].trigger(freq, sIdx, currentWaveform, globalPulseWidth,
-                       activeParams.attackTime, activeParams.releaseTime * 0.3f,
-                       0.7f, activeParams.releaseTime);
-  voices[vIdx].isSparkle = false;
-  voices[vIdx].isLatchedArp = false;
+  // Trigger Note (Voice allocation/stealing happens in the audio engine)
+  postNoteOn(ROLE_STRUM, freq, sIdx, activeParams.attackTime,
+             activeParams.releaseTime * 0.3f, 0.7f, activeParams.releaseTime);
   stringEnergy[sIdx] = 1.0f;
 
   // --- SPARKLE MODE LOGIC ---
@@ -2882,12 +2411,7 @@ void fireArp(int octaveOffset, bool latched) {
 
   // Safety: If Latched, release PREVIOUS Latched voice
   if (latched) {
-    for (int v = 0; v < MAX_VOICES; v++) {
-      if (voices[v].active && voices[v].isLatchedArp) {
-        voices[v].release();
-        // We don't break, in case multiple got stuck
-      }
-    }
+    postVoiceEvent(EVT_RELEASE_LATCHED);
   }
 
   int noteIdx = 0; // Index into activeNotes
@@ -2964,19 +2488,6 @@ void fireArp(int octaveOffset, bool latched) {
 
   // Trigger Logic for Latch vs Unlatched
   if (latched) {
-    // Find Voice
-    int vIdx = -1;
-    // 1. Find Free
-    for (int i = 0; i < MAX_VOICES; i++) {
-      if (!voices[i].active) {
-        vIdx = i;
-        break;
-      }
-    }
-    // 2. Steal Oldest (if not found)
-    if (vIdx == -1)
-      vIdx = 0; // Naive steal
-
     // Freq Calculation (Duplicated from triggerNote slightly, but access
     // needed)
     float freq = baseFreqs[stringIndex];
@@ -2999,24 +2510,133 @@ void fireArp(int octaveOffset, bool latched) {
       sus = 0.0f;
       rel = 0.15f;
     }
-    voices[vIdx].trigger(freq, stringIndex, currentWaveform, globalPulseWidth,
-                         activeParams.attackTime, 0.5f, sus, rel);
-    voices[vIdx].isLatchedArp = true;
+    postNoteOn(ROLE_LATCHED_ARP, freq, stringIndex, activeParams.attackTime,
+               0.5f, sus, rel);
   } else {
     // Enforce Monophony for Manual Arp (Release other unlatched voices)
     // This cleans up the "chordal" confusion when strumming fast
-    for (int v = 0; v < MAX_VOICES; v++) {
-      if (voices[v].active && !voices[v].isLatchedArp) {
-        voices[v].release();
-      }
-    }
+    postVoiceEvent(EVT_RELEASE_UNLATCHED);
 
+    // ROLE_STRUM note-on clears isLatchedArp on whichever voice it lands
     triggerNote(stringIndex);
-    // Note: triggerNote does NOT set isLatchedArp=false explicitely,
-    // but default constructor or previous clear handles it.
-    // However, since we just reused a voice, let's be safe.
-    // But we don't know which voice triggerNote picked!
-    // We updated triggerNote earlier to set `isLatchedArp = false`.
+  }
+}
+
+// --- SERIAL COMMANDS ---
+// Line based, polled from loop() without blocking (newline terminated)
+//   bench : DSP benchmark matrix as CSV (blocks the UI for ~1 min)
+//   stats : Per-stage cycle profile (DSP_PROFILER builds)
+//   stats reset
+//   latency : Touch-to-sound histogram
+//   latency reset / latency overlay
+//   watermark <n> : Speaker wakeup watermark in DMA buffers
+//   btdepth <frames> : BT render-ahead depth
+//   governor : Learned costs + current voice limit
+//   headroom <pct> : Governor headroom target (saved)
+//   softrestart : Toggle phase-keeping same-note retrigger
+//   split : Toggle dual-core voice rendering (saved)
+static void serialEmit(const char *line) { Serial.println(line); }
+
+// --- LATENCY OVERLAY (Hidden: tap the Configuration title) ---
+bool latencyOverlay = false;
+
+void printLatency() {
+  char note[80];
+  if (audioTarget == TARGET_BLUETOOTH) {
+    // render->output already includes the btFeed queue
+    snprintf(note, sizeof(note), "(+ A2DP stack / headset buffering)");
+  } else {
+    snprintf(note, sizeof(note), "(+ up to %d ms queued in I2S DMA)",
+             (audioOutput.fillFrames() * 1000) / SAMPLE_RATE);
+  }
+  latencyProbe.print(serialEmit, note);
+}
+
+void drawLatencyOverlay() {
+  const LatencyHistogram &h = latencyProbe.segment(LAT_TOUCH_TO_OUTPUT);
+  char buf[48];
+  snprintf(buf, sizeof(buf), "LAT p50 %.1f p95 %.1f max %.1f n%u",
+           h.percentile(50) / 1000.0f, h.percentile(95) / 1000.0f,
+           h.maxUs / 1000.0f, (unsigned)h.count);
+
+  tft.fillRect(SCREEN_WIDTH - 230, 63, 230, 12, TFT_BLACK);
+  tft.setTextSize(1);
+  tft.setTextColor(TFT_YELLOW);
+  tft.setTextDatum(TR_DATUM);
+  tft.drawString(buf, SCREEN_WIDTH - 2, 65);
+}
+
+void runSerialCommand(const char *cmd) {
+  if (strcmp(cmd, "bench") == 0) {
+    Serial.println("# Bench: running, UI paused");
+    if (!runDspBenchmark(serialEmit))
+      Serial.println("# Bench: not enough heap for the engine");
+    Serial.println("# Bench: done");
+  } else if (strcmp(cmd, "stats") == 0) {
+    profilerPrint(serialEmit);
+    splitRender.print(serialEmit);
+    if (isBluetoothActive)
+      printAudioRing(serialEmit, "bt_feed", btFeed, BT_SAMPLE_RATE);
+  } else if (strcmp(cmd, "stats reset") == 0) {
+    profilerReset();
+    btFeed.resetStats();
+    Serial.println("Stats: reset");
+  } else if (strcmp(cmd, "latency") == 0) {
+    printLatency();
+  } else if (strcmp(cmd, "latency reset") == 0) {
+    latencyProbe.requestReset();
+    Serial.println("Latency: reset");
+  } else if (strncmp(cmd, "watermark ", 10) == 0) {
+    audioOutput.setWatermark(atoi(cmd + 10));
+    Serial.printf("Audio: wake watermark %d buffer(s) of %d\n",
+                  audioOutput.watermark(), audioOutput.quantum());
+  } else if (strncmp(cmd, "btdepth ", 8) == 0) {
+    setBtFeedDepth(atoi(cmd + 8));
+    Serial.printf("BT: render-ahead %d frames (%d ms)\n", (int)btFeedDepth,
+                  (int)(btFeedDepth * 1000 / BT_SAMPLE_RATE));
+  } else if (strcmp(cmd, "governor") == 0) {
+    audioEngine.governor.print(serialEmit);
+    Serial.printf("  shed         %u voices\n",
+                  (unsigned)audioEngine.voicesShed);
+    Serial.printf("  retired      %u voices (inaudible tail)\n",
+                  (unsigned)audioEngine.voicesRetired);
+    Serial.printf("  reused       %u note-ons\n",
+                  (unsigned)audioEngine.voiceReuses());
+  } else if (strncmp(cmd, "headroom ", 9) == 0) {
+    audioEngine.governor.setHeadroom(atoi(cmd + 9));
+    settings.headroom = audioEngine.governor.headroom();
+    settings.save();
+    Serial.printf("Governor: headroom %d%%\n", settings.headroom);
+  } else if (strcmp(cmd, "split") == 0) {
+    settings.splitRender = !settings.splitRender;
+    settings.save();
+    splitRender.setEnabled(settings.splitRender);
+    splitRender.print(serialEmit);
+  } else if (strcmp(cmd, "softrestart") == 0) {
+    softRestart = !softRestart;
+    audioEngine.publishParams();
+    Serial.printf("Voices: soft restart %s\n", softRestart ? "on" : "off");
+  } else if (strcmp(cmd, "latency overlay") == 0) {
+    latencyOverlay = !latencyOverlay;
+    Serial.printf("Latency: overlay %s\n", latencyOverlay ? "on" : "off");
+  } else {
+    Serial.printf("Unknown command: %s\n", cmd);
+  }
+}
+
+void pollSerialCommands() {
+  static char line[32];
+  static int len = 0;
+  while (Serial.available() > 0) {
+    char c = (char)Serial.read();
+    if (c == '\r' || c == '\n') {
+      line[len] = 0;
+      if (len > 0)
+        runSerialCommand(line);
+      len = 0;
+    } else if (len < (int)sizeof(line) - 1) {
+      line[len++] = c;
+    }
   }
 }
 
@@ -3024,6 +2644,8 @@ void loop() {
   static bool waitForArpRelease = false;
   static uint32_t lastArpClock = 0; // Fix Missing Static in Loop
 
+  pollSerialCommands();
+
   // Robust Clear: Ensure flag resets if screen is not touched, regardless of
   // Mode or Return path
   if (!ts.touched()) {
@@ -3034,30 +2656,11 @@ void loop() {
     uint32_t now = millis();
     for (int i = 0; i < MAX_SPARKS; i++) {
       if (pendingSparks[i].active && now >= pendingSparks[i].triggerTime) {
-        // Compute active voice idx? Or just fire on next available?
-        // Reuse logic from 'triggerNote' or similar.
-        // We need to find an available voice or steal one.
-        // Simplified: Loop active voices or just pick one?
-        // Standard Trigger Logic:
-        int vIdx = -1;
-        // 1. Find Free
-        for (int v = 0; v < MAX_VOICES; v++) {
-          if (!voices[v].active) {
-            vIdx = v;
-            break;
-          }
-        }
-        // 2. Steal Oldest (if none free)
-        if (vIdx == -1) {
-          // Simple steal 0 for now or improved logic?
-          vIdx = 0;
-        }
-
-        voices[vIdx].trigger(pendingSparks[i].freq, pendingSparks[i].stringIdx,
-                             currentWaveform, globalPulseWidth, 0.00f,
-                             pendingSparks[i].releaseTime, 0.0f,
-                             pendingSparks[i].releaseTime);
-        voices[vIdx].isSparkle = true;
+        // Voice is picked on the audio side (free, else quietest steal)
+        postNoteOn(ROLE_SPARKLE, pendingSparks[i].freq,
+                   pendingSparks[i].stringIdx, 0.00f,
+                   pendingSparks[i].releaseTime, 0.0f,
+                   pendingSparks[i].releaseTime);
         stringEnergy[pendingSparks[i].stringIdx] = 1.0f;
 
         pendingSparks[i].active = false;
@@ -3320,15 +2923,11 @@ void loop() {
             // But callback runs on scan results.
 
             audioTarget = TARGET_BLUETOOTH;
-            activeSampleRate = 44100; // Switch to BT rate
+            activeSampleRate = SAMPLE_RATE; // Engine rate (upsampled for BT)
             updateDerivedParameters();
 
-            // CRITICAL: Disable DAC Timer so it doesn't fight BT
-            if (timer != NULL) {
-              timerAlarmDisable(timer);
-              // timerDetachInterrupt(timer); // Removed to prevent crash/reboot
-            }
-            dac_output_disable(DAC_CHANNEL_2); // Free the pin
+            // CRITICAL: Release Speaker I2S so it doesn't fight BT
+            audioOutput.end();
 
             delay(1000);
 
@@ -3359,6 +2958,14 @@ void loop() {
       lastVis = millis();
     }
 
+    static uint32_t lastLatencyDraw = 0;
+    if (latencyOverlay && currentMode == MODE_PLAY &&
+        (audioTarget == TARGET_SPEAKER || audioTarget == TARGET_BLUETOOTH) &&
+        millis() - lastLatencyDraw > 250) {
+      drawLatencyOverlay();
+      lastLatencyDraw = millis();
+    }
+
     // Editor Mode
     if (currentMode == MODE_EDIT) {
       static uint32_t releaseDebounceStart = 0;
@@ -3400,32 +3007,32 @@ void loop() {
     // Periodically Sync Parameters (~50Hz)
     static uint32_t lastParamSync = 0;
     if (millis() - lastParamSync > 20) {
-      // Since LDR is removed, we just ensure globals match activeParams
-      // Filter frequency and resonance are primarily updated here for the
-      // UI/Editor
-      svf_f = 2.0f * sin(PI * activeParams.filterCutoff / (float)SAMPLE_RATE);
-      if (svf_f > 0.95f)
-        svf_f = 0.95f;
-      svf_q = 1.0f - activeParams.filterRes;
-
+      // Since LDR is removed, we just ensure the audio core matches
+      // activeParams. Also picks up FX toggles, volume and profile changes,
+      // and carries the voice ADSR + pulse width sync.
       globalPulseWidth = activeParams.waveFold;
-      globalLfoDepth = activeParams.lfoDepth;
-
-      for (int i = 0; i < MAX_VOICES; i++) {
-        if (!voices[i].isSparkle)
-          voices[i].setADSR(activeParams.attackTime, 0.1f, 0.7f,
-                            activeParams.releaseTime);
-        voices[i].setPulseWidth(globalPulseWidth);
-      }
+      audioEngine.publishParams();
       lastParamSync = millis();
     }
 
     static uint32_t heartbeat = 0;
+    static uint32_t lastSteals = 0;
     if (millis() - heartbeat > 2000) {
-      Serial.printf("ISR: %u | R: %d | W: %d | Fill: %u us | Free: %d\n",
-                    isrCount, bufReadHead, bufWriteHead, lastFillDuration,
-                    (bufReadHead - bufWriteHead + AUDIO_BUF_SIZE - 1) %
-                        AUDIO_BUF_SIZE);
+      uint32_t steals = audioEngine.voiceSteals();
+      float stealRate =
+          (steals - lastSteals) * 1000.0f / (millis() - heartbeat);
+      lastSteals = steals;
+      Serial.printf(
+          "I2S: %s | Fill: %u us | Load: %d%% | Poly: %d | Idle: %d | "
+          "Steals: %.1f/s | DMA: %d fr | XRun: %u (+%u, %u fail) | "
+          "BT ur: %u\n",
+          audioOutput.isRunning() ? audioPresets[audioOutput.presetIndex].name
+                                  : "Off",
+          lastFillDuration, (int)(audioEngine.governor.load() * 100.0f),
+          audioEngine.governor.currentLimit(), audioEngine.isIdle(), stealRate,
+          audioOutput.fillFrames(), (unsigned)audioOutput.underruns,
+          (unsigned)audioOutput.recoveries, (unsigned)audioOutput.installFails,
+          (unsigned)btFeed.getStats().underruns);
       heartbeat = millis();
     }
 
@@ -3434,12 +3041,10 @@ void loop() {
       if (millis() < inputBlockTimer)
         return;
       TS_Point p = ts.getPoint();
+      uint32_t touchMicros = micros(); // Latency probe
       if (p.z < 600) { // Increased threshold for stability
         if (lastTouchedString != -1) {
-          for (int v = 0; v < MAX_VOICES; v++) {
-            if (voices[v].active && voices[v].held && !voices[v].isLatchedArp)
-              voices[v].release();
-          }
+          postVoiceEvent(EVT_RELEASE_HELD);
         }
         lastTouchedString = -1;
         return;
@@ -3455,9 +3060,17 @@ void loop() {
       // --- TOUCH DISPATCH ---
       if (audioTarget == TARGET_CONFIG) {
         int startY = 60, btnH = 45, btnW = 200, gap = 15;
+        // 0. Hidden: Title toggles the latency overlay
+        if (ty < 45) {
+          latencyOverlay = !latencyOverlay;
+          Serial.printf("Latency: overlay %s\n", latencyOverlay ? "on" : "off");
+          delay(250);
+          return;
+        }
         // 1. Audio Config
         if (ty > startY && ty < startY + btnH) {
           audioTarget = TARGET_AUDIO_CONFIG;
+          applyAudioPreset(settings.audioProfileIndex); // Live preview
           drawAudioConfigScreen();
           delay(250);
           return;
@@ -3489,6 +3102,7 @@ void loop() {
             settings.audioProfileIndex++;
             if (settings.audioProfileIndex >= AUDIO_PRESET_COUNT)
               settings.audioProfileIndex = 0;
+            applyAudioPreset(settings.audioProfileIndex);
             drawAudioConfigScreen(); // Redraw with new name
             delay(200);
           }
@@ -3499,14 +3113,22 @@ void loop() {
             drawAudioConfigScreen();
             delay(250);
           }
-          // OK (x=260, w=100)
-          else if (tx > 260 && tx < 360) {
+          // OK (x=260, w=40)
+          else if (tx > 260 && tx < 300) {
             // Save and Exit
             settings.save();
+            isAudioTestRunning = false;
             audioTarget = TARGET_CONFIG;
             drawConfigMenu();
             delay(250);
           }
+          // Latency Mode (x=320, w=140)
+          else if (tx > 320 && tx < 460) {
+            settings.lowLatency = !settings.lowLatency;
+            applyAudioPreset(settings.audioProfileIndex);
+            drawAudioConfigScreen();
+            delay(250);
+          }
         }
         return;
       }
@@ -3592,11 +3214,9 @@ void loop() {
         int sIdx = (tx * numStrings) / SCREEN_WIDTH;
         if (sIdx != lastTouchedString) {
           if (lastTouchedString != -1) {
-            for (int v = 0; v < MAX_VOICES; v++) {
-              if (voices[v].active && voices[v].held && !voices[v].isLatchedArp)
-                voices[v].release();
-            }
+            postVoiceEvent(EVT_RELEASE_HELD);
           }
+          latencyProbe.touch(touchMicros);
           if (arpMode != ARP_OFF && !arpLatch) {
             if (currentChordMask & (1 << (getGlobalNoteIndex(sIdx) % 12))) {
               int gIdx = getGlobalNoteIndex(sIdx);
@@ -3605,6 +3225,7 @@ void loop() {
           } else {
             triggerNote(sIdx);
           }
+          latencyProbe.takeTouch(); // Unused if the note was masked out
           lastTouchedString = sIdx;
         }
       }
@@ -3647,10 +3268,7 @@ void loop() {
     } else { // No Touch Logic (On Release)
       if (lastTouchedString != -1) {
         // Release any voices tied to the last strummed string
-        for (int v = 0; v < MAX_VOICES; v++) {
-          if (voices[v].active && voices[v].held && !voices[v].isLatchedArp)
-            voices[v].release();
-        }
+        postVoiceEvent(EVT_RELEASE_HELD);
       }
       lastTouchedString = -1;
       waitForArpRelease = false;
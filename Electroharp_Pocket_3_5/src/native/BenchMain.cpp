@@ -0,0 +1,16 @@
+// --- DSP BENCHMARK (PlatformIO env:native_bench) ---
+// Host run of runDspBenchmark(): CSV on stdout, ns per output sample.
+//   pio run -e native_bench && .pio/build/native_bench/program > bench.csv
+#include "../Benchmark.h"
+#include "../SynthVoice.h"
+
+static void emitLine(const char *line) { puts(line); }
+
+int main() {
+  SynthVoice::initLUT();
+  if (!runDspBenchmark(emitLine)) {
+    fprintf(stderr, "Benchmark: out of memory\n");
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,18 @@
+// --- Engine Inputs (main.cpp on the device) ---
+// Shared by the native programs (RenderWav, BenchMain).
+#include "../AudioEngine.h"
+
+// Same defaults as the firmware's activeParams
+SynthParameters activeParams = {
+    3500.0f, 0.70f, 0.50f, 0.50f, 0.05f,         2.0f, 0.35f,
+    0.30f,   0.20f, 5.0f,  LFO_SINE, TARGET_FILTER, 4};
+volatile int activeSampleRate = SAMPLE_RATE;
+Waveform currentWaveform = WAVE_SAW;
+bool fxDrive = false;
+bool fxTrem = false;
+bool fxLFO = false;
+int delayMode = 0;
+float masterVolume = 0.8f;
+bool isAudioTestRunning = false;
+bool softRestart = true;
+float outputLsb = 1.0f / 30000.0f; // 16-bit WAV
@@ -0,0 +1,337 @@
+// --- OFFLINE WAV RENDERER (PlatformIO env:native) ---
+// Runs the firmware DSP core (AudioEngine + voices + FX + upsampler) on the
+// desktop and renders a scripted timeline to a 16-bit mono WAV.
+//
+//   pio run -e native
+//   .pio/build/native/program timeline.txt out.wav [22050|44100]
+//
+// 22050 Hz is the wired speaker path (spkProfile, engine output as written
+// to an external I2S DAC). 44100 Hz is the A2DP path (btProfile, 2x
+// half-band upsampler, BT output trim). Events land on render block
+// boundaries exactly like the UI -> audio queue on the device, so the
+// result is the sample-exact engine output for that timeline.
+//
+// Timeline: one "<time_ms> <command> [args]" per line, '#' comments.
+//   note <idx>            Strum string idx (0 = C1, semitones, like triggerNote)
+//   hz <freq>             Strum an explicit frequency
+//   lift                  Touch lifted (release held voices)
+//   release_all           Unlatch + release everything
+//   wave saw|square|sine|tri
+//   set <param> <value>   cutoff res fold feedback attack release lforate
+//                         lfodepth drive tremrate lfotype lfotarget
+//   fx drive|trem|lfo on|off
+//   delay <0-4>           0=Off, 1=300ms ... 4=1200ms
+//   volume <0-1>
+//   end                   Stop rendering here (default: last event + 2s)
+#include "../AudioEngine.h"
+#include "../Upsampler.h"
+#include <vector>
+
+struct TimelineEvent {
+  long sample; // Engine-rate position (SAMPLE_RATE)
+  char cmd[16];
+  char arg1[16];
+  char arg2[16];
+};
+
+static bool isBT = false;
+
+// --- UI Side (mirrors main.cpp) ---
+// updateDerivedParameters() + the 50Hz parameter sync
+static void applyParams() {
+  if (activeParams.filterRes > 0.95f)
+    activeParams.filterRes = 0.95f;
+  audioEngine.publishParams();
+
+  NoteEvent e;
+  e.type = EVT_ENV_PARAMS;
+  e.attack = activeParams.attackTime;
+  e.release = activeParams.releaseTime;
+  e.waveform = currentWaveform;
+  audioEngine.post(e);
+}
+
+// triggerNote(): profile cap + C1 clamp, strum envelope
+static void strum(float freq, int noteIdx) {
+  float cap = isBT ? 4800.0f : 3200.0f;
+  if (freq > cap)
+    freq = cap;
+  if (freq < 32.7f)
+    freq = 32.7f;
+
+  NoteEvent e;
+  e.type = EVT_NOTE_ON;
+  e.role = ROLE_STRUM;
+  e.freq = freq;
+  e.noteIdx = noteIdx;
+  e.waveform = currentWaveform;
+  e.pw = activeParams.waveFold;
+  e.attack = activeParams.attackTime;
+  e.decay = activeParams.releaseTime * 0.3f;
+  e.sustain = 0.7f;
+  e.release = activeParams.releaseTime;
+  audioEngine.post(e);
+}
+
+static void postSimple(NoteEventType type) {
+  NoteEvent e;
+  e.type = type;
+  audioEngine.post(e);
+}
+
+static bool setParam(const char *name, float v) {
+  if (!strcmp(name, "cutoff"))
+    activeParams.filterCutoff = v;
+  else if (!strcmp(name, "res"))
+    activeParams.filterRes = v;
+  else if (!strcmp(name, "fold"))
+    activeParams.waveFold = v;
+  else if (!strcmp(name, "feedback"))
+    activeParams.delayFeedback = v;
+  else if (!strcmp(name, "attack"))
+    activeParams.attackTime = v;
+  else if (!strcmp(name, "release"))
+    activeParams.releaseTime = v;
+  else if (!strcmp(name, "lforate"))
+    activeParams.lfoRate = v;
+  else if (!strcmp(name, "lfodepth"))
+    activeParams.lfoDepth = v;
+  else if (!strcmp(name, "drive"))
+    activeParams.driveAmount = v;
+  else if (!strcmp(name, "tremrate"))
+    activeParams.tremRate = v;
+  else if (!strcmp(name, "lfotype"))
+    activeParams.lfoType = (LfoType)(int)v;
+  else if (!strcmp(name, "lfotarget"))
+    activeParams.lfoTarget = (LfoTarget)(int)v;
+  else
+    return false;
+  return true;
+}
+
+static bool dispatch(const TimelineEvent &ev) {
+  const char *c = ev.cmd;
+  if (!strcmp(c, "note")) {
+    int idx = atoi(ev.arg1);
+    strum(32.703f * powf(2.0f, idx / 12.0f), idx);
+  } else if (!strcmp(c, "hz")) {
+    strum((float)atof(ev.arg1), -1);
+  } else if (!strcmp(c, "lift")) {
+    postSimple(EVT_RELEASE_HELD);
+  } else if (!strcmp(c, "release_all")) {
+    postSimple(EVT_RELEASE_ALL);
+  } else if (!strcmp(c, "wave")) {
+    if (!strcmp(ev.arg1, "saw"))
+      currentWaveform = WAVE_SAW;
+    else if (!strcmp(ev.arg1, "square"))
+      currentWaveform = WAVE_SQUARE;
+    else if (!strcmp(ev.arg1, "sine"))
+      currentWaveform = WAVE_SINE;
+    else if (!strcmp(ev.arg1, "tri"))
+      currentWaveform = WAVE_TRIANGLE;
+    else
+      return false;
+    applyParams();
+  } else if (!strcmp(c, "set")) {
+    if (!setParam(ev.arg1, (float)atof(ev.arg2)))
+      return false;
+    applyParams();
+  } else if (!strcmp(c, "fx")) {
+    bool on = !strcmp(ev.arg2, "on");
+    if (!strcmp(ev.arg1, "drive"))
+      fxDrive = on;
+    else if (!strcmp(ev.arg1, "trem"))
+      fxTrem = on;
+    else if (!strcmp(ev.arg1, "lfo"))
+      fxLFO = on;
+    else
+      return false;
+    applyParams();
+  } else if (!strcmp(c, "delay")) {
+    delayMode = atoi(ev.arg1);
+    if (delayMode < 0 || delayMode > 4)
+      return false;
+    applyParams();
+  } else if (!strcmp(c, "volume")) {
+    masterVolume = (float)atof(ev.arg1);
+    applyParams();
+  } else {
+    return false;
+  }
+  return true;
+}
+
+// --- TIMELINE PARSER ---
+static bool loadTimeline(const char *path, std::vector<TimelineEvent> &out,
+                         long &endSample) {
+  FILE *f = fopen(path, "r");
+  if (!f) {
+    fprintf(stderr, "Cannot open %s\n", path);
+    return false;
+  }
+
+  char line[256];
+  int lineNo = 0;
+  endSample = -1;
+  long lastSample = 0;
+  while (fgets(line, sizeof(line), f)) {
+    lineNo++;
+    char *hash = strchr(line, '#');
+    if (hash)
+      *hash = 0;
+
+    TimelineEvent ev;
+    memset(&ev, 0, sizeof(ev));
+    float ms = 0.0f;
+    int n = sscanf(line, "%f %15s %15s %15s", &ms, ev.cmd, ev.arg1, ev.arg2);
+    if (n <= 0)
+      continue; // Blank / comment
+    if (n < 2 || ms < 0.0f) {
+      fprintf(stderr, "%s:%d: expected <time_ms> <command>\n", path, lineNo);
+      fclose(f);
+      return false;
+    }
+
+    ev.sample = (long)(ms * SAMPLE_RATE / 1000.0f + 0.5f);
+    if (ev.sample < lastSample) {
+      fprintf(stderr, "%s:%d: timeline must be in time order\n", path, lineNo);
+      fclose(f);
+      return false;
+    }
+    lastSample = ev.sample;
+
+    if (!strcmp(ev.cmd, "end")) {
+      endSample = ev.sample;
+      break;
+    }
+    out.push_back(ev);
+  }
+  fclose(f);
+
+  if (endSample < 0)
+    endSample = lastSample + 2 * SAMPLE_RATE; // Let the tails ring out
+  return true;
+}
+
+// --- WAV WRITER (16-bit PCM Mono) ---
+static void put16(FILE *f, uint16_t v) {
+  fputc(v & 0xFF, f);
+  fputc(v >> 8, f);
+}
+
+static void put32(FILE *f, uint32_t v) {
+  put16(f, v & 0xFFFF);
+  put16(f, v >> 16);
+}
+
+static bool writeWav(const char *path, const std::vector<int16_t> &pcm,
+                     int rate) {
+  FILE *f = fopen(path, "wb");
+  if (!f) {
+    fprintf(stderr, "Cannot write %s\n", path);
+    return false;
+  }
+  uint32_t dataBytes = (uint32_t)pcm.size() * 2;
+  fwrite("RIFF", 1, 4, f);
+  put32(f, 36 + dataBytes);
+  fwrite("WAVEfmt ", 1, 8, f);
+  put32(f, 16);
+  put16(f, 1); // PCM
+  put16(f, 1); // Mono
+  put32(f, rate);
+  put32(f, rate * 2);
+  put16(f, 2);
+  put16(f, 16);
+  fwrite("data", 1, 4, f);
+  put32(f, dataBytes);
+  for (size_t i = 0; i < pcm.size(); i++)
+    put16(f, (uint16_t)pcm[i]);
+  fclose(f);
+  return true;
+}
+
+// Output Adapters (AudioOutput::write external DAC / writeBtFrame)
+static int16_t toPcm(float s, float trim) {
+  if (s > 1.0f)
+    s = 1.0f;
+  if (s < -1.0f)
+    s = -1.0f;
+  return (int16_t)(s * trim * 30000.0f);
+}
+
+int main(int argc, char **argv) {
+  if (argc < 3) {
+    fprintf(stderr, "Usage: %s <timeline.txt> <out.wav> [22050|44100]\n",
+            argv[0]);
+    return 1;
+  }
+  int outRate = (argc > 3) ? atoi(argv[3]) : SAMPLE_RATE;
+  if (outRate != SAMPLE_RATE && outRate != SAMPLE_RATE * 2) {
+    fprintf(stderr, "Output rate must be %d or %d\n", SAMPLE_RATE,
+            SAMPLE_RATE * 2);
+    return 1;
+  }
+
+  std::vector<TimelineEvent> timeline;
+  long endSample = 0;
+  if (!loadTimeline(argv[1], timeline, endSample))
+    return 1;
+
+  // Mode setup (setupBluetooth / setupSpeaker)
+  isBT = (outRate != SAMPLE_RATE);
+  currentProfile = isBT ? &btProfile : &spkProfile;
+  outputLsb = isBT ? 1.0f / (0.65f * 30000.0f) : 1.0f / 30000.0f;
+  activeSampleRate = SAMPLE_RATE;
+  SynthVoice::initLUT();
+  audioEngine.buildTables();
+  audioEngine.governor.setEnabled(false); // Timing-independent output
+  applyParams();
+
+  HalfBandUpsampler upsampler;
+  upsampler.reset();
+  float trim = isBT ? 0.65f : 1.0f;
+
+  std::vector<int16_t> pcm;
+  pcm.reserve((size_t)endSample * (isBT ? 2 : 1));
+
+  float block[AUDIO_BLOCK_SIZE];
+  float up[AUDIO_BLOCK_SIZE * 2];
+  size_t next = 0;
+  for (long pos = 0; pos < endSample; pos += AUDIO_BLOCK_SIZE) {
+    // Everything due before the end of this block is drained at its start
+    while (next < timeline.size() &&
+           timeline[next].sample < pos + AUDIO_BLOCK_SIZE) {
+      if (!dispatch(timeline[next])) {
+        fprintf(stderr, "Bad command at %ld: %s %s %s\n",
+                timeline[next].sample, timeline[next].cmd,
+                timeline[next].arg1, timeline[next].arg2);
+        return 1;
+      }
+      next++;
+    }
+
+    int n = AUDIO_BLOCK_SIZE;
+    if (pos + n > endSample)
+      n = (int)(endSample - pos);
+    audioEngine.render(block, n);
+
+    if (isBT) {
+      upsampler.process(block, up, n);
+      for (int i = 0; i < n * 2; i++)
+        pcm.push_back(toPcm(up[i], trim));
+    } else {
+      for (int i = 0; i < n; i++)
+        pcm.push_back(toPcm(block[i], trim));
+    }
+  }
+
+  if (audioEngine.droppedEvents > 0)
+    fprintf(stderr, "Warning: %u events dropped (queue full)\n",
+            (unsigned)audioEngine.droppedEvents);
+
+  if (!writeWav(argv[2], pcm, outRate))
+    return 1;
+  printf("%s: %u samples @ %d Hz (%s path)\n", argv[2], (unsigned)pcm.size(),
+         outRate, isBT ? "A2DP" : "speaker");
+  return 0;
+}